@@ -0,0 +1,481 @@
+//coroutine agent engine for the simulator
+//every attacker and sysadmin is a C++20 coroutine that co_awaits simulated
+//delays, so one iteration of an agent is a single scheduler entry instead of
+//a DEPLOY/EXECUTE event pair. Needs -std=c++20
+
+#ifndef AGENTS_H
+#define AGENTS_H
+#if __cplusplus < 202002L
+#error "agents.hpp needs -std=c++20"
+#endif
+#include "simulator.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <vector>
+
+/*
+ * Free lists of coroutine frames in 64 byte size classes. Frames are carved
+ * out of slabs that are kept until the pool goes away, so once a frame of a
+ * size has been released, allocating one is a pop off a list.
+ */
+class FramePool {
+	private:
+		static const int CLASS_BYTES = 64;
+		static const int NUM_CLASSES = 32;   //frames over 2 KB go to operator new
+		static const int SLAB_FRAMES = 64;
+
+		struct FreeFrame {
+			FreeFrame* next;
+		};
+		FreeFrame* freeLists[NUM_CLASSES];
+		std::vector<char*> slabs;
+		long long allocations;
+
+		void refill(int sizeClass);
+
+	public:
+		FramePool() : allocations(0) {
+			for(int i = 0; i < NUM_CLASSES; i++)
+				freeLists[i] = nullptr;
+		}
+		~FramePool() {
+			for(unsigned int i = 0; i < slabs.size(); i++)
+				::operator delete(slabs[i]);
+		}
+		FramePool(const FramePool&) = delete;
+		FramePool& operator=(const FramePool&) = delete;
+
+		void* allocate(std::size_t size);
+		void release(void* frame, std::size_t size);
+		long long getAllocations() const { return this->allocations; }
+		int getNumSlabs() const { return this->slabs.size(); }
+};
+
+void FramePool::refill(int sizeClass) {
+	std::size_t frameBytes = (sizeClass + 1) * CLASS_BYTES;
+	char* slab = (char*)::operator new(frameBytes * SLAB_FRAMES);
+	slabs.push_back(slab);
+	for(int i = SLAB_FRAMES - 1; i >= 0; i--) {
+		FreeFrame* frame = (FreeFrame*)(slab + i * frameBytes);
+		frame->next = freeLists[sizeClass];
+		freeLists[sizeClass] = frame;
+	}
+}
+
+void* FramePool::allocate(std::size_t size) {
+	allocations++;
+	int sizeClass = (size + CLASS_BYTES - 1) / CLASS_BYTES - 1;
+	if(sizeClass >= NUM_CLASSES)
+		return ::operator new(size);
+	if(!freeLists[sizeClass])
+		refill(sizeClass);
+	FreeFrame* frame = freeLists[sizeClass];
+	freeLists[sizeClass] = frame->next;
+	return frame;
+}
+
+void FramePool::release(void* frame, std::size_t size) {
+	int sizeClass = (size + CLASS_BYTES - 1) / CLASS_BYTES - 1;
+	if(sizeClass >= NUM_CLASSES) {
+		::operator delete(frame);
+		return;
+	}
+	FreeFrame* freed = (FreeFrame*)frame;
+	freed->next = freeLists[sizeClass];
+	freeLists[sizeClass] = freed;
+}
+
+//one pool per process, every agent frame comes from here
+inline FramePool& framePool() {
+	static FramePool pool;
+	return pool;
+}
+
+/*
+ * Owner of an agent coroutine. The coroutine starts suspended and stays
+ * suspended at the end, so the frame lives until the AgentTask goes away.
+ */
+class AgentTask {
+	public:
+		struct promise_type {
+			AgentTask get_return_object() {
+				return AgentTask(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() { }
+			void unhandled_exception() { std::terminate(); }
+
+			static void* operator new(std::size_t size) { return framePool().allocate(size); }
+			static void operator delete(void* frame, std::size_t size) { framePool().release(frame, size); }
+		};
+
+		AgentTask() : handle(nullptr) { }
+		explicit AgentTask(std::coroutine_handle<promise_type> handle) : handle(handle) { }
+		AgentTask(AgentTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+		AgentTask& operator=(AgentTask&& other) noexcept {
+			if(this != &other) {
+				if(handle)
+					handle.destroy();
+				handle = other.handle;
+				other.handle = nullptr;
+			}
+			return *this;
+		}
+		AgentTask(const AgentTask&) = delete;
+		AgentTask& operator=(const AgentTask&) = delete;
+		~AgentTask() {
+			if(handle)
+				handle.destroy();
+		}
+
+		std::coroutine_handle<> getHandle() const { return this->handle; }
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+};
+
+//the wake key orders equal times, so handles never tie on anything else
+inline bool wakeTiebreaker(std::coroutine_handle<>&, int, std::coroutine_handle<>&, int) {
+	return false;
+}
+
+/*
+ * Same model as BasicSimulator, but the scheduler holds only a coroutine
+ * handle and a wake key per entry. The key is time * 4 + rank, which keeps
+ * the event engine's order on a tie: attacks, then fixes, then rebuilds.
+ * Policies are the ones BasicSimulator takes, with the Scheduler holding
+ * std::coroutine_handle<> instead of Event.
+ */
+template<typename Scheduler = PriorityQueue<std::coroutine_handle<>, wakeTiebreaker>,
+         typename Network = Graph,
+         typename FixQueue = SysAdmin,
+         typename RNG = MersenneRNG>
+class AgentSimulator {
+	private:
+		enum RANK {
+			ATTACK_RANK = 0,
+			FIX_RANK = 1,
+			REBUILD_RANK = 2
+		};
+
+		//input values
+		int numAttackers;
+		int numSysadmins;
+		int numComputers;
+		int seed;
+
+		//time and number of attack
+		int t;
+		int numAttack;
+		long long numEvents = 0;
+		bool started = false;
+
+		//Agent and queue
+		Network computerNetwork;
+		FixQueue sysAdminsQueue;
+		Scheduler pq;
+		bool checkRebuild = false;
+		bool sysAdminsDeployed = false;
+
+		//Attack batching, as in BasicSimulator, whose runs it changes the same way
+		bool batchAttacks = false;
+		bool pendingPartitionCheck = false;
+		long long numPartitionChecks = 0;
+		bool attackPending();
+		void checkPartition();
+
+		//Node up/down history for offline analysis
+		bool recordRun = false;
+		RunRecording recording;
+
+		//Rebuild reports also appended to a columnar file when set
+		MetricsWriter* metrics = nullptr;
+
+		//Optimal cost after every attack and fix
+		bool trackOptimal = false;
+		void reportOptimal() {
+			if(this->trackOptimal)
+				std::cout << "Optimal_Cost(" << t << "): " << computerNetwork.currentOptimalCost() << std::endl;
+		}
+
+		//Random number generation
+		RNG mt;
+		int randomDelay(int agent, int low, int high) {  return this->mt.uniform(agent, low, high);  }
+		bool sampleLive = false;
+		int randomComputer(int agent) {
+			if(this->sampleLive && computerNetwork.numLiveTargets() > 0)
+				return computerNetwork.liveTarget(this->mt.uniform(agent, 0, computerNetwork.numLiveTargets() - 1));
+			return this->mt.uniform(agent, 0, numComputers - 1);
+		}
+
+		//suspends the awaiting agent until time
+		struct WakeAt {
+			AgentSimulator* simulator;
+			long long key;
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { simulator->pq.push(handle, key); }
+			void await_resume() const noexcept { }
+		};
+		WakeAt wakeAt(int time, RANK rank) {  return WakeAt{this, (long long)time * 4 + rank};  }
+		static ACTION wakeAction(long long key) {
+			return (key & 3) == ATTACK_RANK ? EXECUTE_ATTACK : (key & 3) == FIX_RANK ? EXECUTE_FIX : EXECUTE_REBUILD;
+		}
+
+		//Agents
+		AgentTask attacker(int id);
+		AgentTask sysadmin(int id);
+		AgentTask rebuilder();
+		void requestRebuild();
+
+		//frames are destroyed before anything they point into
+		AgentTask rebuildTask;
+		std::vector<AgentTask> agents;
+
+	public:
+		AgentSimulator(int numAttackers, int numSysadmins, int numComputers, int seed);
+		void setBatchAttacks(bool batch) { this->batchAttacks = batch; }
+		void setRecordRun(bool record) { this->recordRun = record; }
+		//Appends every rebuild report to metrics as well, before the run
+		void setMetrics(MetricsWriter* metrics) { this->metrics = metrics; }
+		void setSampleLive(bool live) {
+			this->sampleLive = live;
+			computerNetwork.setTrackLive(live);
+		}
+		void setTrackOptimal(bool track) {
+			this->trackOptimal = track;
+			computerNetwork.setTrackOptimal(track);
+		}
+		const RunRecording& getRecording() const { return this->recording; }
+		std::vector<ConnectivitySnapshot> analyzeConnectivity();
+
+		//Entry points
+		void start();
+		bool step();
+		void runUntil(int time);
+		void run();
+
+		bool finished() const { return this->numAttack >= 2000; }
+		int getTime() const { return this->t; }
+		long long getNumEvents() const { return this->numEvents; }
+		long long getNumPartitionChecks() const { return this->numPartitionChecks; }
+		Network& getNetwork() { return this->computerNetwork; }
+#ifdef SIMULATION_STATS
+		const Stats& getStats() const { return simulationStats(); }
+#endif
+};
+
+//Constructor
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+AgentSimulator<Scheduler, Network, FixQueue, RNG>::AgentSimulator(int numAttackers, int numSysadmins, int numComputers, int seed)
+	: computerNetwork(numComputers, seed), sysAdminsQueue(numComputers),
+	  mt(seed, numAttackers + numSysadmins) {
+	this->numAttackers = numAttackers;
+	this->numSysadmins = numSysadmins;
+	this->numComputers = numComputers;
+	this->seed = seed;
+
+	this->t = 0;
+	this->numAttack = 0;
+	//one pending wake up per agent and two for the rebuild at most, so
+	//the scheduler never grows mid run
+	this->pq.reserve(numAttackers + numSysadmins + 2);
+}
+
+//Starts the attackers, called once by the other entry points
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void AgentSimulator<Scheduler, Network, FixQueue, RNG>::start() {
+	if(this->started)
+		return;
+	this->started = true;
+
+	std::cout << "STARTING SIMULATION" << std::endl;
+	//parks straight away, requestRebuild() wakes it
+	this->rebuildTask = this->rebuilder();
+	this->rebuildTask.getHandle().resume();
+
+	this->agents.reserve(numAttackers + numSysadmins);
+	for(int i = 0; i < numAttackers; i++) {
+		this->agents.push_back(this->attacker(i));
+		this->agents.back().getHandle().resume();
+	}
+}
+
+//Resumes the next agent, false if none is waiting
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+bool AgentSimulator<Scheduler, Network, FixQueue, RNG>::step() {
+	this->start();
+	if(pq.isEmpty())
+		return false;
+
+	auto next = pq.pop();
+	this->t = next.priority >> 2;
+	{
+		STATS_TIME_EVENT(wakeAction(next.priority));
+		next.content.resume();
+	}
+	(this->numEvents)++;
+	if(this->pendingPartitionCheck && !this->attackPending())
+		this->checkPartition();
+	STATS_EVENT(pq.size(), sysAdminsQueue.size());
+	return true;
+}
+
+//Whether another attacker wakes at the current time
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+bool AgentSimulator<Scheduler, Network, FixQueue, RNG>::attackPending() {
+	return !this->finished() && !pq.isEmpty() && pq.peekPriority() == (long long)this->t * 4 + ATTACK_RANK;
+}
+
+//rebuild when the spanning tree is partitioned
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void AgentSimulator<Scheduler, Network, FixQueue, RNG>::checkPartition() {
+	this->pendingPartitionCheck = false;
+	(this->numPartitionChecks)++;
+	if(computerNetwork.partitioned())
+		this->requestRebuild();
+}
+
+//Processes every wake up to and including time, stopping early at the
+//stopping condition
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void AgentSimulator<Scheduler, Network, FixQueue, RNG>::runUntil(int time) {
+	this->start();
+	while(!this->finished() && !pq.isEmpty() && (pq.peekPriority() >> 2) <= time)
+		this->step();
+}
+
+//Runs the simulation until 2000 attacks have occurred
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void AgentSimulator<Scheduler, Network, FixQueue, RNG>::run() {
+	this->start();
+	while(!this->finished()) {
+		if(!this->step())
+			break;
+	}
+	std::cout << "ATTACK FINISHED" << std::endl;
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+std::vector<ConnectivitySnapshot> AgentSimulator<Scheduler, Network, FixQueue, RNG>::analyzeConnectivity() {
+	std::vector<std::pair<int, int> > edges;
+	computerNetwork.lowerEdges(edges);
+	ConnectivityAnalysis analysis(numComputers, edges, recording);
+	return analysis.getSnapshots();
+}
+
+//Picks a target, waits for the attack time and compromises it
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+AgentTask AgentSimulator<Scheduler, Network, FixQueue, RNG>::attacker(int id) {
+	for(;;) {
+		GraphNode* target = computerNetwork.getNode(this->randomComputer(id));
+		int time = this->t + this->randomDelay(id, 100, 1000);
+		std::cout << "Deploy_Attack(" << time << ", " << target->originalName << ")" << std::endl;
+		co_await this->wakeAt(time, ATTACK_RANK);
+
+		(this->numAttack)++;
+		std::cout << "Execute_Attack(" << t << ", " << target->originalName << ")" << std::endl;
+		if(this->finished())
+			co_return;
+
+		const ArenaVector<GraphNode*>& adjNodes = target->adjNodes;
+		if(this->recordRun) {
+			recording.nodeDown(t, target->originalName);
+			for(unsigned int i = 0; i < adjNodes.size(); i++)
+				recording.nodeDown(t, adjNodes[i]->originalName);
+		}
+
+		//re-broken machines don't get a re-entry
+		if(!sysAdminsQueue.check(target))
+			sysAdminsQueue.push(target);
+		for(unsigned int i = 0; i < adjNodes.size(); i++)
+			if(!sysAdminsQueue.check(adjNodes[i]))
+				sysAdminsQueue.push(adjNodes[i]);
+
+		computerNetwork.attacked(target);
+		this->reportOptimal();
+
+		//sysadmins start fixing after the first node is compromised
+		if(!sysAdminsDeployed) {
+			sysAdminsDeployed = true;
+			for(int i = 0; i < numSysadmins; i++) {
+				this->agents.push_back(this->sysadmin(numAttackers + i));
+				this->agents.back().getHandle().resume();
+			}
+		}
+
+		if(this->batchAttacks) {
+			if(!this->checkRebuild)
+				this->pendingPartitionCheck = true;
+		} else {
+			this->checkPartition();
+		}
+	}
+}
+
+//Fixes the head of the fix queue every so often, if there is one
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+AgentTask AgentSimulator<Scheduler, Network, FixQueue, RNG>::sysadmin(int id) {
+	for(;;) {
+		int time = this->t + this->randomDelay(id, 1000, 2000);
+		std::cout << "Deploy_Fix(" << time << ")" << std::endl;
+		co_await this->wakeAt(time, FIX_RANK);
+
+		//nothing to fix, check again later
+		if(sysAdminsQueue.isEmpty())
+			continue;
+
+		GraphNode* target = sysAdminsQueue.pop();
+		std::cout << "Execute_Repair(" << target->originalName << ")" << std::endl;
+		computerNetwork.fixed(target);
+		this->reportOptimal();
+		if(this->recordRun)
+			recording.nodeUp(t, target->originalName);
+		this->requestRebuild();
+	}
+}
+
+//Sleeps until requestRebuild() wakes it, then rebuilds
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+AgentTask AgentSimulator<Scheduler, Network, FixQueue, RNG>::rebuilder() {
+	for(;;) {
+		co_await std::suspend_always();
+
+		std::cout << "Execute_Rebuild(" << t << ")" << std::endl;
+		this->computerNetwork.rebuild();
+		this->checkRebuild = false;
+		//the stats sample and the metrics row share one pass over the nodes
+		bool counting = this->metrics != nullptr;
+#ifdef SIMULATION_STATS
+		counting = true;
+#endif
+		int components = counting ? computerNetwork.componentCount() : 0;
+		STATS_SAMPLE(t, pq.size(), sysAdminsQueue.size(), components);
+
+		const std::vector<int>& missing = computerNetwork.missingNodes();
+		long long treeCost = computerNetwork.spanningTreeCost();
+		std::cout << "Spanning tree cost is " << treeCost << ". Missing nodes:";
+		for(unsigned int i = 0; i < missing.size(); i++)
+			std::cout << " " << missing[i];
+		std::cout << std::endl;
+		std::cout << "Optimal MST cost is " << computerNetwork.optimalCost() << "." << std::endl;
+		if(this->metrics)
+			this->metrics->append(t, treeCost, computerNetwork.optimalCost(), components, missing);
+	}
+}
+
+//Rebuild is scheduled when not already pending
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void AgentSimulator<Scheduler, Network, FixQueue, RNG>::requestRebuild() {
+	if(!(this->checkRebuild)) {
+		int time = this->t + 20;
+		std::coroutine_handle<> handle = this->rebuildTask.getHandle();
+		this->pq.push(handle, (long long)time * 4 + REBUILD_RANK);
+		std::cout << "Deploy_Rebuild(" << time << ")" << std::endl;
+	}
+	this->checkRebuild = true;
+}
+
+#endif
@@ -0,0 +1,146 @@
+//monotonic arena for per-graph storage
+//everything a Graph owns is carved out of a few large blocks that are only
+//released together, so teardown is one free per block no matter how many
+//objects live in them
+
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/*
+ * Blocks of 2 MB or more are aligned to 2 MB and, on Linux, marked for
+ * transparent huge pages. Smaller blocks are cache line aligned. A request
+ * that does not fit the current block opens a new one, reserve() the
+ * expected total up front so the bulk lands in one block. Blocks opened
+ * for later growth start at 64 KB and double each time.
+ */
+class Arena {
+	private:
+		static const std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+		static const std::size_t MIN_BLOCK = 64 * 1024;
+		//growth blocks double, so the block list rarely outgrows this and
+		//opening a block costs no operator new
+		static const std::size_t BLOCK_LIST = 32;
+
+		struct Block {
+			char* base;
+			std::size_t size;
+			std::size_t used;
+		};
+		std::vector<Block> blocks;
+		std::size_t nextBlockSize;
+		std::size_t reserved;
+		std::size_t used;
+
+		void addBlock(std::size_t bytes);
+
+	public:
+		Arena() : nextBlockSize(MIN_BLOCK), reserved(0), used(0) {
+			blocks.reserve(BLOCK_LIST);
+		}
+		explicit Arena(std::size_t initialBytes) : nextBlockSize(MIN_BLOCK), reserved(0), used(0) {
+			blocks.reserve(BLOCK_LIST);
+			reserve(initialBytes);
+		}
+		~Arena() {
+			for(unsigned int i = 0; i < blocks.size(); i++)
+				free(blocks[i].base);
+		}
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		//makes sure the next bytes of requests come from one block
+		void reserve(std::size_t bytes) {
+			if(blocks.empty() || blocks.back().size - blocks.back().used < bytes)
+				addBlock(bytes);
+		}
+
+		void* allocate(std::size_t bytes, std::size_t align = 16);
+
+		//uninitialized storage for count objects
+		template<typename T>
+		T* allocateArray(std::size_t count) {
+			return (T*)allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+		}
+
+		std::size_t getReserved() const { return this->reserved; }
+		std::size_t getUsed() const { return this->used; }
+		int getNumBlocks() const { return this->blocks.size(); }
+};
+
+void Arena::addBlock(std::size_t bytes) {
+	std::size_t size = (bytes > nextBlockSize) ? bytes : nextBlockSize;
+	std::size_t align = 64;
+	if(size >= HUGE_PAGE) {
+		align = HUGE_PAGE;
+		size = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+	}
+	void* base = nullptr;
+	if(posix_memalign(&base, align, size) != 0)
+		throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+	if(align == HUGE_PAGE)
+		madvise(base, size, MADV_HUGEPAGE);
+#endif
+	Block block = {(char*)base, size, 0};
+	blocks.push_back(block);
+	reserved += size;
+	if(bytes <= nextBlockSize)
+		nextBlockSize *= 2;
+}
+
+void* Arena::allocate(std::size_t bytes, std::size_t align) {
+	if(!blocks.empty()) {
+		Block& block = blocks.back();
+		std::size_t start = (block.used + align - 1) & ~(align - 1);
+		if(start + bytes <= block.size) {
+			used += start + bytes - block.used;
+			block.used = start + bytes;
+			return block.base + start;
+		}
+	}
+	addBlock(bytes + align);
+	return allocate(bytes, align);
+}
+
+/*
+ * Standard allocator handing out arena memory. Freeing is a no-op, the
+ * memory goes back with the arena. Without an arena it falls back to
+ * operator new so containers using it can still be default constructed.
+ */
+template<typename T>
+class ArenaAllocator {
+	public:
+		typedef T value_type;
+		Arena* arena;
+
+		ArenaAllocator() : arena(nullptr) { }
+		ArenaAllocator(Arena* arena) : arena(arena) { }
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) { }
+
+		T* allocate(std::size_t count) {
+			if(arena)
+				return arena->allocateArray<T>(count);
+			return (T*)::operator new(count * sizeof(T));
+		}
+		void deallocate(T* pointer, std::size_t) {
+			if(!arena)
+				::operator delete(pointer);
+		}
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {  return lhs.arena == rhs.arena;  }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {  return lhs.arena != rhs.arena;  }
+#endif
@@ -0,0 +1,546 @@
+//benchmark suite for the simulator
+//micro benchmarks time the data structures on their own, macro benchmarks
+//time Simulator::run() end to end. Every result is one JSON object per line
+//on stdout so runs can be compared by a script. The alloc mode checks that
+//a warmed up simulation no longer calls operator new and exits with 1 if
+//it does.
+
+#include "simulator.hpp"
+#include "agents.hpp"
+#include "countnew.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <streambuf>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//swallows everything the simulator prints
+class NullBuffer : public std::streambuf {
+	protected:
+		int overflow(int c) { return c; }
+		std::streamsize xsputn(const char*, std::streamsize n) { return n; }
+};
+
+using benchClock = std::chrono::steady_clock;
+
+//keeps results the compiler could otherwise throw away
+static volatile long long benchSink;
+
+static double elapsedNs(benchClock::time_point start) {
+	return std::chrono::duration<double, std::nano>(benchClock::now() - start).count();
+}
+
+//a forked child inherits the peak RSS of its parent, so reset the high water
+//mark first (Linux only, ignored elsewhere)
+static void resetPeakRss() {
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	if(clearRefs)
+		clearRefs << "5";
+}
+
+//peak resident set size of this process in KB
+static long peakRssKb() {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while(std::getline(status, line))
+		if(line.compare(0, 6, "VmHWM:") == 0)
+			return atol(line.c_str() + 6);
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static void report(const char* name, int n, long long ops, double ns) {
+	std::printf("{\"bench\":\"%s\",\"n\":%d,\"ops\":%lld,\"total_ns\":%.0f,\"ns_per_op\":%.2f}\n",
+		name, n, ops, ns, ops > 0 ? ns / ops : 0.0);
+	std::fflush(stdout);
+}
+
+//Graph keeps its build steps private
+struct GraphBench {
+	static double build(Graph& g) {
+		auto start = benchClock::now();
+		g.build();
+		return elapsedNs(start);
+	}
+	static double fakeBuild(Graph& g) {
+		g.fakeReset();
+		auto start = benchClock::now();
+		g.fakeBuild();
+		return elapsedNs(start);
+	}
+	//takes a node down or brings it back without touching the tree
+	static double toggle(Graph& g, int node) {
+		auto start = benchClock::now();
+		if(g.downNodes.test(g.slot(node)))
+			g.nodeUp(g.slot(node));
+		else
+			g.nodeDown(g.slot(node));
+		return elapsedNs(start);
+	}
+};
+
+static void benchHeap(int n) {
+	PriorityQueue<Event, tiebreaker> pq;
+	std::mt19937 mt(n);
+	std::uniform_int_distribution<int> priority(0, 1 << 30);
+	Event e;
+	e.action = DEPLOY_ATTACK;
+
+	auto start = benchClock::now();
+	for(int i = 0; i < n; i++)
+		pq.push(e, priority(mt));
+	report("heap_push", n, n, elapsedNs(start));
+
+	start = benchClock::now();
+	while(!pq.isEmpty())
+		pq.pop();
+	report("heap_pop", n, n, elapsedNs(start));
+}
+
+template<typename RNG>
+static void benchRng(const char* name, int n) {
+	RNG rng(n, 64);
+	long long sum = 0;
+	auto start = benchClock::now();
+	for(int i = 0; i < n; i++)
+		sum += rng.uniform(i & 63, 100, 1000);
+	report(name, n, n, elapsedNs(start));
+	benchSink = sum;
+}
+
+static void benchGraph(int n, int seed, bool reorder) {
+	auto start = benchClock::now();
+	Graph g(n, seed);
+	report("graph_construct", n, 1, elapsedNs(start));
+	if(reorder) {
+		start = benchClock::now();
+		g.reorderNodes();
+		report("graph_reorder", n, 1, elapsedNs(start));
+	}
+	const Arena& arena = g.getArena();
+	std::printf("{\"bench\":\"graph_memory\",\"n\":%d,\"arena_blocks\":%d,\"arena_reserved\":%zu,"
+		"\"arena_used\":%zu,\"bytes_per_node\":%.1f}\n",
+		n, arena.getNumBlocks(), arena.getReserved(), arena.getUsed(), (double)arena.getUsed() / n);
+
+	report("graph_build", n, 1, GraphBench::build(g));
+	report("graph_fake_build", n, 1, GraphBench::fakeBuild(g));
+
+	start = benchClock::now();
+	g.partitioned();
+	report("graph_partitioned", n, 1, elapsedNs(start));
+
+	start = benchClock::now();
+	const RoutingTable& routes = g.getRoutes();
+	report("routing_refresh", n, 1, elapsedNs(start));
+
+	const int queries = 1000000;
+	std::mt19937 mt(seed);
+	std::uniform_int_distribution<int> node(0, n - 1);
+	std::vector<int> pairs(2 * queries);
+	for(int i = 0; i < 2 * queries; i++)
+		pairs[i] = node(mt);
+	long long sum = 0;
+	start = benchClock::now();
+	for(int i = 0; i < queries; i++) {
+		Route route = routes.route(pairs[2 * i], pairs[2 * i + 1]);
+		sum += route.cost + route.hops + route.bottleneck;
+	}
+	report("routing_query", n, queries, elapsedNs(start));
+	benchSink = sum;
+}
+
+//keeping the optimal cost current on every node change against recomputing
+//it with fakeBuild() after each one
+static void benchOptimal(int n, int seed) {
+	Graph g(n, seed);
+	g.setTrackOptimal(true);
+	const int changes = 500;
+	std::mt19937 mt(seed);
+	std::uniform_int_distribution<int> node(0, n - 1);
+	std::vector<int> down;
+	double dynamicNs = 0, recomputeNs = 0;
+	int mismatches = 0;
+	for(int i = 0; i < changes; i++) {
+		//about a tenth of the network is down at a time
+		int target = node(mt);
+		if(!g.isDown(target) && (int)down.size() >= n / 10) {
+			int pick = node(mt) % down.size();
+			target = down[pick];
+			down[pick] = down.back();
+			down.pop_back();
+		} else if(g.isDown(target)) {
+			for(unsigned int j = 0; j < down.size(); j++)
+				if(down[j] == target) {
+					down[j] = down.back();
+					down.pop_back();
+					break;
+				}
+		} else {
+			down.push_back(target);
+		}
+		dynamicNs += GraphBench::toggle(g, target);
+		recomputeNs += GraphBench::fakeBuild(g);
+		if(g.optimalCost() != g.currentOptimalCost())
+			mismatches++;
+	}
+	report("optimal_dynamic", n, changes, dynamicNs);
+	report("optimal_recompute", n, changes, recomputeNs);
+	if(mismatches)
+		std::printf("{\"bench\":\"optimal_dynamic\",\"n\":%d,\"error\":\"%d costs differ from recomputation\"}\n",
+			n, mismatches);
+}
+
+//answers every timestamp of a recorded run in one pass
+static void benchConnectivity(int n, int seed) {
+	Simulator simulator(20, 20, n, seed);
+	simulator.setRecordRun(true);
+	simulator.run();
+
+	auto start = benchClock::now();
+	std::vector<ConnectivitySnapshot> snapshots = simulator.analyzeConnectivity();
+	report("connectivity_offline", n, snapshots.size(), elapsedNs(start));
+}
+
+static void benchSysAdmin(int n) {
+	GraphNode* nodes = new GraphNode[n];
+	for(int i = 0; i < n; i++)
+		nodes[i].originalName = i;
+	SysAdmin queue(n);
+
+	auto start = benchClock::now();
+	for(int i = 0; i < n; i++)
+		queue.push(&nodes[i]);
+	report("sysadmin_push", n, n, elapsedNs(start));
+
+	int found = 0;
+	start = benchClock::now();
+	for(int i = 0; i < n; i++)
+		found += queue.check(&nodes[(i * 7919LL) % n]);
+	report("sysadmin_check", n, n, elapsedNs(start));
+
+	start = benchClock::now();
+	while(!queue.isEmpty())
+		queue.pop();
+	report("sysadmin_pop", n, n, elapsedNs(start));
+	benchSink = found;
+
+	delete[] nodes;
+}
+
+//attack records through the feed's producer thread and ring, drained as
+//fast as the consumer can take them
+static void benchFeed(int n) {
+	char path[] = "/tmp/bench_feed_XXXXXX";
+	int fd = mkstemp(path);
+	if(fd == -1) {
+		std::perror("mkstemp");
+		return;
+	}
+	std::FILE* out = fdopen(fd, "w");
+	for(int i = 0; i < n; i++)
+		std::fprintf(out, "%d %d\n", i, (int)((i * 7919LL) % 100000));
+	std::fclose(out);
+
+	auto start = benchClock::now();
+	long long sum = 0;
+	{
+		AttackFeed feed(path);
+		AttackRecord record;
+		while(feed.next(record))
+			sum += record.target;
+	}
+	report("feed_ingest", n, n, elapsedNs(start));
+	benchSink = sum;
+	unlink(path);
+}
+
+//a run of rebuilds over numNodes nodes, about 2% of them missing with two
+//swapped between rebuilds: written, scanned by column, then read back row
+//by row with every missing set decoded
+static void benchMetrics(int rows, int numNodes) {
+	char path[] = "/tmp/bench_metrics_XXXXXX";
+	int fd = mkstemp(path);
+	if(fd == -1) {
+		std::perror("mkstemp");
+		return;
+	}
+	close(fd);
+
+	mt1337 mt(1234);
+	std::uniform_int_distribution<int> node(0, numNodes - 1);
+	std::vector<int> missing;
+	for(int i = 0; i < numNodes / 50; i++)
+		missing.push_back(node(mt));
+	std::sort(missing.begin(), missing.end());
+	missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+	auto start = benchClock::now();
+	{
+		MetricsWriter writer(path, numNodes);
+		for(int i = 0; i < rows; i++) {
+			for(int k = 0; k < 2; k++) {
+				int down = node(mt);
+				std::vector<int>::iterator at = std::lower_bound(missing.begin(), missing.end(), down);
+				if(at != missing.end() && *at == down)
+					continue;
+				int up = std::uniform_int_distribution<int>(0, missing.size() - 1)(mt);
+				missing.erase(missing.begin() + up);
+				at = std::lower_bound(missing.begin(), missing.end(), down);
+				missing.insert(at, down);
+			}
+			writer.append(i, 100000 + i % 977, 90000 + i % 613, 1 + i % 7, missing);
+		}
+	}
+	report("metrics_write", numNodes, rows, elapsedNs(start));
+
+	std::FILE* file = std::fopen(path, "rb");
+	std::fseek(file, 0, SEEK_END);
+	long bytes = std::ftell(file);
+	std::fclose(file);
+	std::printf("{\"bench\":\"metrics_file\",\"n\":%d,\"rows\":%d,\"bytes\":%ld,\"bytes_per_row\":%.2f}\n",
+		numNodes, rows, bytes, (double)bytes / rows);
+
+	start = benchClock::now();
+	long long sum = 0;
+	{
+		MetricsReader reader(path);
+		while(reader.readBlock()) {
+			const MetricsBlock& block = reader.getBlock();
+			for(int i = 0; i < block.rows(); i++)
+				sum += block.treeCost[i] - block.optimalCost[i];
+		}
+	}
+	report("metrics_scan", numNodes, rows, elapsedNs(start));
+
+	start = benchClock::now();
+	{
+		MetricsReader reader(path);
+		MetricsRow row;
+		while(reader.next(row))
+			sum += row.missing.size();
+	}
+	report("metrics_decode", numNodes, rows, elapsedNs(start));
+	benchSink = sum;
+	unlink(path);
+}
+
+//each run is forked so its peak RSS is not hidden by earlier, larger runs
+template<typename SimulatorType>
+static void benchSimulation(const char* engine, const char* rng, bool batch, bool live, bool reorder, bool small, int shards, int attackers, int sysadmins, int n, int seed) {
+	std::fflush(stdout);
+	pid_t pid = fork();
+	if(pid < 0) {
+		std::perror("fork");
+		return;
+	}
+	if(pid == 0) {
+		resetPeakRss();
+		auto start = benchClock::now();
+		SimulatorType simulator(attackers, sysadmins, n, seed);
+		if(reorder)
+			simulator.getNetwork().reorderNodes();
+		simulator.setBatchAttacks(batch);
+		simulator.setSampleLive(live);
+		double setupNs = elapsedNs(start);
+		start = benchClock::now();
+		simulator.run();
+		double ns = elapsedNs(start);
+		long long events = simulator.getNumEvents();
+		const ForestCache& cache = simulator.getNetwork().getOptimalCache();
+		std::printf("{\"bench\":\"simulation\",\"engine\":\"%s\",\"rng\":\"%s\",\"batch\":%s,\"live\":%s,\"reorder\":%s,\"small\":%s,\"shards\":%d,\"n\":%d,\"attackers\":%d,\"sysadmins\":%d,"
+			"\"events\":%lld,\"partition_checks\":%lld,\"setup_ns\":%.0f,\"run_ns\":%.0f,\"events_per_sec\":%.1f,"
+			"\"ns_per_event\":%.2f,\"optimal_cache_hits\":%lld,\"optimal_cache_lookups\":%lld,\"peak_rss_kb\":%ld}\n",
+			engine, rng, batch ? "true" : "false", live ? "true" : "false", reorder ? "true" : "false",
+			small ? "true" : "false", shards, n, attackers, sysadmins, events,
+			simulator.getNumPartitionChecks(), setupNs, ns,
+			events / (ns / 1e9), events > 0 ? ns / events : 0.0, cache.getHits(), cache.getLookups(), peakRssKb());
+		std::fflush(stdout);
+		_exit(0);
+	}
+	int status;
+	waitpid(pid, &status, 0);
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		std::printf("{\"bench\":\"simulation\",\"n\":%d,\"attackers\":%d,\"error\":\"child failed\"}\n",
+			n, attackers);
+}
+
+//the engine and rng picked on the command line, over one network type
+template<typename Network>
+static void benchSimulationOn(const std::string& engine, const std::string& rng, bool batch, bool live, bool reorder, bool small, int shards, int attackers, int sysadmins, int n, int seed) {
+	if(engine == "coroutines" && rng == "xoshiro")
+		benchSimulation<AgentSimulator<PriorityQueue<std::coroutine_handle<>, wakeTiebreaker>, Network, SysAdmin, XoshiroRNG<> > >(
+			"coroutines", "xoshiro", batch, live, reorder, small, shards, attackers, sysadmins, n, seed);
+	else if(engine == "coroutines")
+		benchSimulation<AgentSimulator<PriorityQueue<std::coroutine_handle<>, wakeTiebreaker>, Network> >(
+			"coroutines", "mt", batch, live, reorder, small, shards, attackers, sysadmins, n, seed);
+	else if(rng == "xoshiro")
+		benchSimulation<BasicSimulator<PriorityQueue<Event, tiebreaker>, Network, SysAdmin, XoshiroRNG<> > >(
+			"events", "xoshiro", batch, live, reorder, small, shards, attackers, sysadmins, n, seed);
+	else
+		benchSimulation<BasicSimulator<PriorityQueue<Event, tiebreaker>, Network> >(
+			"events", "mt", batch, live, reorder, small, shards, attackers, sysadmins, n, seed);
+}
+
+//runs warmup events, then counts operator new calls and new arena blocks
+//over the rest of the run. Only operator new fails the check: adjNodes and
+//name path stacks grow with the run in the graph's arena, which opens a
+//doubling block when they outgrow it. The recorded run of --connectivity
+//grows by design and is not covered
+template<typename SimulatorType>
+static bool benchAllocations(const char* engine, const char* options, int attackers, int sysadmins, int n, int seed) {
+	SimulatorType simulator(attackers, sysadmins, n, seed);
+	bool batch = strstr(options, "batch") != nullptr;
+	bool live = strstr(options, "live") != nullptr;
+	bool optimal = strstr(options, "optimal") != nullptr;
+	if(strstr(options, "reorder"))
+		simulator.getNetwork().reorderNodes();
+	simulator.setBatchAttacks(batch);
+	simulator.setSampleLive(live);
+	simulator.setTrackOptimal(optimal);
+
+	const long long warmup = 1000;
+	while(simulator.getNumEvents() < warmup && !simulator.finished() && simulator.step()) { }
+	long long allocations = numAllocations;
+	int blocks = simulator.getNetwork().getArena().getNumBlocks();
+	long long events = simulator.getNumEvents();
+	while(!simulator.finished() && simulator.step()) { }
+	allocations = numAllocations - allocations;
+	blocks = simulator.getNetwork().getArena().getNumBlocks() - blocks;
+	events = simulator.getNumEvents() - events;
+
+	bool clean = allocations == 0;
+	std::printf("{\"bench\":\"steady_state_allocations\",\"engine\":\"%s\",\"options\":\"%s\",\"n\":%d,"
+		"\"attackers\":%d,\"sysadmins\":%d,\"warmup_events\":%lld,\"events\":%lld,\"allocations\":%lld,"
+		"\"arena_blocks\":%d,\"pass\":%s}\n",
+		engine, options, n, attackers, sysadmins, warmup, events, allocations, blocks, clean ? "true" : "false");
+	std::fflush(stdout);
+	return clean;
+}
+
+static std::vector<int> parseList(const char* text) {
+	std::vector<int> values;
+	std::string item;
+	for(const char* c = text; ; c++) {
+		if(*c == ',' || *c == '\0') {
+			if(!item.empty())
+				values.push_back(atoi(item.c_str()));
+			item.clear();
+			if(*c == '\0')
+				break;
+		} else {
+			item += *c;
+		}
+	}
+	return values;
+}
+
+static void usage() {
+	std::cout << "Usage: ./bench [micro|macro|alloc|all] [--sizes n1,n2,...] [--attackers a1,a2,...] "
+		<< "[--sysadmins s] [--seed s] [--rng mt|xoshiro] [--batch] [--live] [--reorder] [--small] [--shards k] [--engine events|coroutines]" << std::endl;
+	std::cout << "Full sweep: ./bench macro --sizes 100,500,1000,2000,5000,10000,20000" << std::endl;
+	exit(1);
+}
+
+int main(int argc, char** argv) {
+	std::string mode = "all";
+	std::vector<int> sizes = {100, 200};
+	std::vector<int> attackers = {20, 100};
+	int sysadmins = 20;
+	int seed = 1234;
+	std::string rng = "mt";
+	bool batch = false;
+	bool live = false;
+	bool reorder = false;
+	bool small = false;
+	int shards = 0;
+	std::string engine = "events";
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "micro") || !strcmp(argv[i], "macro") || !strcmp(argv[i], "alloc") || !strcmp(argv[i], "all"))
+			mode = argv[i];
+		else if(!strcmp(argv[i], "--sizes") && i + 1 < argc)
+			sizes = parseList(argv[++i]);
+		else if(!strcmp(argv[i], "--attackers") && i + 1 < argc)
+			attackers = parseList(argv[++i]);
+		else if(!strcmp(argv[i], "--sysadmins") && i + 1 < argc)
+			sysadmins = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--rng") && i + 1 < argc)
+			rng = argv[++i];
+		else if(!strcmp(argv[i], "--batch"))
+			batch = true;
+		else if(!strcmp(argv[i], "--live"))
+			live = true;
+		else if(!strcmp(argv[i], "--reorder"))
+			reorder = true;
+		else if(!strcmp(argv[i], "--small"))
+			small = true;
+		else if(!strcmp(argv[i], "--shards") && i + 1 < argc)
+			shards = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--engine") && i + 1 < argc)
+			engine = argv[++i];
+		else
+			usage();
+	}
+
+	NullBuffer nullBuffer;
+	std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+	if(mode == "alloc") {
+		static const char* configs[] = {"", "batch", "live", "optimal", "reorder", "batch,live,optimal"};
+		bool clean = true;
+		for(unsigned int i = 0; i < sizes.size(); i++)
+			for(unsigned int j = 0; j < attackers.size(); j++)
+				for(unsigned int k = 0; k < sizeof(configs) / sizeof(configs[0]); k++) {
+					clean &= benchAllocations<Simulator>("events", configs[k], attackers[j], sysadmins, sizes[i], seed);
+					clean &= benchAllocations<BasicSimulator<PriorityQueue<Event, tiebreaker>, Graph, SysAdmin, XoshiroRNG<> > >(
+						"events_xoshiro", configs[k], attackers[j], sysadmins, sizes[i], seed);
+					clean &= benchAllocations<AgentSimulator<> >("coroutines", configs[k], attackers[j], sysadmins, sizes[i], seed);
+					if(sizes[i] <= 256)
+						clean &= benchAllocations<BasicSimulator<PriorityQueue<Event, tiebreaker>, SmallGraph<256> > >(
+							"events_small", configs[k], attackers[j], sysadmins, sizes[i], seed);
+				}
+		std::cout.rdbuf(coutBuffer);
+		return clean ? 0 : 1;
+	}
+
+	if(mode != "macro") {
+		benchHeap(1000000);
+		benchSysAdmin(1000000);
+		benchFeed(10000000);
+		benchMetrics(1000000, 10000);
+		benchRng<MersenneRNG>("rng_mt", 10000000);
+		benchRng<XoshiroRNG<4> >("rng_xoshiro4", 10000000);
+		benchRng<XoshiroRNG<8> >("rng_xoshiro8", 10000000);
+		for(unsigned int i = 0; i < sizes.size(); i++) {
+			benchGraph(sizes[i], seed, reorder);
+			benchOptimal(sizes[i], seed);
+			benchConnectivity(sizes[i], seed);
+		}
+	}
+	if(mode != "micro") {
+		ShardedGraph::setDefaultWorkers(shards);
+		for(unsigned int i = 0; i < sizes.size(); i++)
+			for(unsigned int j = 0; j < attackers.size(); j++) {
+				//the bit row graph covers networks of up to 256 nodes
+				if(small && sizes[i] <= 256)
+					benchSimulationOn<SmallGraph<256> >(engine, rng, batch, live, reorder, true, 0, attackers[j], sysadmins, sizes[i], seed);
+				else if(shards > 0)
+					benchSimulationOn<ShardedGraph>(engine, rng, batch, live, reorder, false, shards, attackers[j], sysadmins, sizes[i], seed);
+				else
+					benchSimulationOn<Graph>(engine, rng, batch, live, reorder, false, 0, attackers[j], sysadmins, sizes[i], seed);
+			}
+	}
+
+	std::cout.rdbuf(coutBuffer);
+	return 0;
+}
@@ -1,69 +1,61 @@
 //Code taken from www.github.com/nilocunger
 
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <random>
 
 #include "graph.hpp"
+#include "export.hpp"
 
-char *lpad(char *text, int length, char padWith) {
-  char *padded = new char[length+1];
-  int textLength = strlen(text);
-  for (int i=0; i < length; i++) { 
-    if (i >= length - textLength) {
-      padded[i] = text[i - (length - textLength)];
+void usage() {
+  std::cout << "Usage: generate <num_nodes> [<seed>] [--format text|matrix|csv|dot|binary] [--output <file>] [--reorder]" << std::endl;
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  std::vector<char*> positional;
+  EXPORT_FORMAT format = FORMAT_TEXT;
+  const char* output = nullptr;
+  bool reorder = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+      if (!parseExportFormat(argv[++i], format))
+        usage();
+    } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+      output = argv[++i];
+    } else if (!strcmp(argv[i], "--reorder")) {
+      reorder = true;
     } else {
-      padded[i] = padWith;
+      positional.push_back(argv[i]);
     }
   }
-  padded[length] = '\0';
-  return padded;
-}
 
-int main(int argc, char **argv) {
   int seed;
-  if (argc == 2) {
+  if (positional.size() == 1) {
     seed = (std::random_device())();
-  } else if (argc == 3) {
-    seed = atoi(argv[2]);
+  } else if (positional.size() == 2) {
+    seed = atoi(positional[1]);
   } else {
-    std::cout << "Usage: generate <num_nodes> [<seed>]" << std::endl;
-    exit(1);
+    usage();
   }
 
-  int numNodes = atoi(argv[1]);
+  int numNodes = atoi(positional[0]);
   Graph g(numNodes, seed);
-  const int * const* adjMatrix = g.getAdjMatrix();
-	const int * const* spanningTree = g.getSpanningTree();
-	const std::vector<Edge> edges = g.getEdges();
+  if (reorder)
+    g.reorderNodes();
 
-	//Print AdjMatrix
-  for (int i = 0; i < numNodes; i++) {
-    for (int j = 0; j < numNodes; j++) {
-      char element[4];
-      sprintf(element, "%d", adjMatrix[i][j]);
-      char *padded = lpad(element, 3, ' ');
-      std::cout << padded << " "; 
-      delete[] padded;
-    }
-    std::cout << std::endl;
+  FILE* file = output ? fopen(output, "wb") : stdout;
+  if (!file) {
+    perror(output);
+    exit(1);
   }
-	
-
-	//Print Edges
-	for (unsigned int i = 0; i < edges.size(); i++) {
-    std::cout << "Cost is " << edges[i].cost << std::endl;
-	}
-
-	std::cout << "\nSpanning Tree begins " << std::endl;
-
-	//Print Spanning Trees
-	for (int i = 0; i < numNodes; i++) 
-		for (int j = 0; j < numNodes; j++) {
-			if(spanningTree[i][j] > 0) {
-			   std::cout << i << " node and " <<  j << " node has " << spanningTree[i][j] << " cost." << std::endl;
-			}
-		}
+  {
+    ExportBuffer buffer(file);
+    exportGraph(g, format, buffer);
+  }
+  if (output)
+    fclose(file);
   return 0;
 }
@@ -0,0 +1,227 @@
+//offline dynamic connectivity over a recorded run
+//every edge of the network is alive while both of its endpoints are up, so
+//a run is a set of edge lifetimes over time. Those intervals go into a
+//segment tree over the timestamps and one depth first walk of the tree with
+//an undoable union find answers every timestamp at once, in
+//O((V + E) log T log V)
+
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+//one node going down (compromised or affected) or coming back up
+struct NodeChange {
+	int time;
+	int node;
+	bool down;
+};
+
+//The attacked/fixed node events of a run, in simulated time order
+class RunRecording {
+	private:
+		std::vector<NodeChange> changes;
+	public:
+		void nodeDown(int time, int node) {
+			NodeChange change = {time, node, true};
+			changes.push_back(change);
+		}
+		void nodeUp(int time, int node) {
+			NodeChange change = {time, node, false};
+			changes.push_back(change);
+		}
+		const std::vector<NodeChange>& getChanges() const { return this->changes; }
+};
+
+//The surviving network once every change at time has been applied
+struct ConnectivitySnapshot {
+	int time;
+	int alive;
+	int components;
+	int largest;
+};
+
+/*
+ * Union find with union by size and no path compression, so every union
+ * can be undone by popping it off a history stack.
+ */
+class RollbackUnionFind {
+	private:
+		struct Undo {
+			int child;      //root that was attached, -1 if the union did nothing
+			int largest;    //largest component before the union
+		};
+		std::vector<int> parent;
+		std::vector<int> size;
+		std::vector<Undo> history;
+		int largest;
+		int unions;
+
+		int find(int node) const {
+			while(parent[node] != node)
+				node = parent[node];
+			return node;
+		}
+
+	public:
+		RollbackUnionFind(int numNodes) : parent(numNodes), size(numNodes, 1), largest(1), unions(0) {
+			for(int i = 0; i < numNodes; i++)
+				parent[i] = i;
+		}
+
+		void unite(int left, int right) {
+			Undo undo = {-1, largest};
+			left = find(left);
+			right = find(right);
+			if(left != right) {
+				if(size[left] < size[right])
+					std::swap(left, right);
+				parent[right] = left;
+				size[left] += size[right];
+				if(size[left] > largest)
+					largest = size[left];
+				undo.child = right;
+				unions++;
+			}
+			history.push_back(undo);
+		}
+
+		int checkpoint() const { return this->history.size(); }
+
+		void rollback(int checkpoint) {
+			while((int)history.size() > checkpoint) {
+				Undo undo = history.back();
+				history.pop_back();
+				largest = undo.largest;
+				if(undo.child != -1) {
+					int root = parent[undo.child];
+					size[root] -= size[undo.child];
+					parent[undo.child] = undo.child;
+					unions--;
+				}
+			}
+		}
+
+		int getLargest() const { return this->largest; }
+		int getUnions() const { return this->unions; }
+};
+
+class ConnectivityAnalysis {
+	private:
+		int numNodes;
+		int numTimes;
+		std::vector<int> times;                       //distinct timestamps, times[0] is the start
+		std::vector<int> alive;                       //live nodes per timestamp
+		std::vector<std::vector<std::pair<int, int> > > segments;  //edges per segment tree node
+		std::vector<ConnectivitySnapshot> snapshots;
+
+		void insert(int node, int low, int high, int from, int to, const std::pair<int, int>& edge);
+		void walk(int node, int low, int high, RollbackUnionFind& sets);
+
+	public:
+		//edges are undirected and listed once
+		ConnectivityAnalysis(int numNodes, const std::vector<std::pair<int, int> >& edges,
+			const RunRecording& recording);
+		const std::vector<ConnectivitySnapshot>& getSnapshots() const { return this->snapshots; }
+};
+
+ConnectivityAnalysis::ConnectivityAnalysis(int numNodes, const std::vector<std::pair<int, int> >& edges,
+		const RunRecording& recording) : numNodes(numNodes) {
+	const std::vector<NodeChange>& changes = recording.getChanges();
+
+	//compress time, index 0 is the network before the first change
+	times.push_back(0);
+	for(unsigned int i = 0; i < changes.size(); i++)
+		if(changes[i].time != times.back())
+			times.push_back(changes[i].time);
+	numTimes = times.size();
+
+	//up intervals of every node as [from, to) in time indices, ignoring
+	//changes that do not flip the node's state
+	std::vector<std::vector<std::pair<int, int> > > upIntervals(numNodes);
+	std::vector<int> upSince(numNodes, 0);
+	std::vector<int> delta(numTimes + 1, 0);
+	int index = 0;
+	for(unsigned int i = 0; i < changes.size(); i++) {
+		while(times[index] != changes[i].time)
+			index++;
+		int node = changes[i].node;
+		if(changes[i].down && upSince[node] != -1) {
+			if(upSince[node] < index)
+				upIntervals[node].push_back(std::make_pair(upSince[node], index));
+			upSince[node] = -1;
+			delta[index]--;
+		} else if(!changes[i].down && upSince[node] == -1) {
+			upSince[node] = index;
+			delta[index]++;
+		}
+	}
+	for(int node = 0; node < numNodes; node++)
+		if(upSince[node] != -1 && upSince[node] < numTimes)
+			upIntervals[node].push_back(std::make_pair(upSince[node], numTimes));
+
+	alive.resize(numTimes);
+	int count = numNodes;
+	for(int i = 0; i < numTimes; i++) {
+		count += delta[i];
+		alive[i] = count;
+	}
+
+	//an edge lives in the intersection of its endpoints' up intervals
+	segments.resize(4 * numTimes);
+	for(unsigned int e = 0; e < edges.size(); e++) {
+		const std::vector<std::pair<int, int> >& left = upIntervals[edges[e].first];
+		const std::vector<std::pair<int, int> >& right = upIntervals[edges[e].second];
+		unsigned int i = 0, j = 0;
+		while(i < left.size() && j < right.size()) {
+			int from = std::max(left[i].first, right[j].first);
+			int to = std::min(left[i].second, right[j].second);
+			if(from < to)
+				insert(1, 0, numTimes, from, to, edges[e]);
+			if(left[i].second < right[j].second)
+				i++;
+			else
+				j++;
+		}
+	}
+
+	RollbackUnionFind sets(numNodes);
+	snapshots.resize(numTimes);
+	walk(1, 0, numTimes, sets);
+}
+
+//adds edge to the segment tree nodes covering [from, to)
+void ConnectivityAnalysis::insert(int node, int low, int high, int from, int to, const std::pair<int, int>& edge) {
+	if(to <= low || high <= from)
+		return;
+	if(from <= low && high <= to) {
+		segments[node].push_back(edge);
+		return;
+	}
+	int mid = (low + high) / 2;
+	insert(2 * node, low, mid, from, to, edge);
+	insert(2 * node + 1, mid, high, from, to, edge);
+}
+
+void ConnectivityAnalysis::walk(int node, int low, int high, RollbackUnionFind& sets) {
+	int checkpoint = sets.checkpoint();
+	for(unsigned int i = 0; i < segments[node].size(); i++)
+		sets.unite(segments[node][i].first, segments[node][i].second);
+
+	if(high - low == 1) {
+		//down nodes are singletons in the union find, they don't count
+		ConnectivitySnapshot& snapshot = snapshots[low];
+		snapshot.time = times[low];
+		snapshot.alive = alive[low];
+		snapshot.components = alive[low] - sets.getUnions();
+		snapshot.largest = (alive[low] > 0) ? sets.getLargest() : 0;
+	} else {
+		int mid = (low + high) / 2;
+		walk(2 * node, low, mid, sets);
+		walk(2 * node + 1, mid, high, sets);
+	}
+
+	sets.rollback(checkpoint);
+}
+#endif
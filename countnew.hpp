@@ -0,0 +1,66 @@
+//counting replacement of the global operator new and delete
+//include it from exactly one translation unit of a program. Every form of
+//operator new, plain, array, nothrow and aligned, counts one allocation and
+//every form of operator delete frees through the same function, so whatever
+//a warmed up simulation still allocates shows up in numAllocations
+
+#ifndef COUNTNEW_H
+#define COUNTNEW_H
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+static long long numAllocations = 0;
+
+//kept out of line so the compiler never pairs a free() with an inlined new
+__attribute__((noinline)) static void* countedAllocate(std::size_t size, std::size_t align) {
+	numAllocations++;
+	void* pointer = nullptr;
+	if(align <= alignof(std::max_align_t))
+		pointer = malloc(size ? size : 1);
+	else if(posix_memalign(&pointer, align, size ? size : 1) != 0)
+		pointer = nullptr;
+	return pointer;
+}
+
+__attribute__((noinline)) static void countedFree(void* pointer) {
+	free(pointer);
+}
+
+static void* countedNew(std::size_t size, std::size_t align) {
+	void* pointer = countedAllocate(size, align);
+	if(!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new(std::size_t size) {  return countedNew(size, 0);  }
+void* operator new[](std::size_t size) {  return countedNew(size, 0);  }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {  return countedAllocate(size, 0);  }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {  return countedAllocate(size, 0);  }
+
+void operator delete(void* pointer) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer) noexcept {  countedFree(pointer);  }
+void operator delete(void* pointer, std::size_t) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer, std::size_t) noexcept {  countedFree(pointer);  }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {  countedFree(pointer);  }
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t align) {  return countedNew(size, (std::size_t)align);  }
+void* operator new[](std::size_t size, std::align_val_t align) {  return countedNew(size, (std::size_t)align);  }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return countedAllocate(size, (std::size_t)align);
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return countedAllocate(size, (std::size_t)align);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer, std::align_val_t) noexcept {  countedFree(pointer);  }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {  countedFree(pointer);  }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {  countedFree(pointer);  }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {  countedFree(pointer);  }
+#endif
+#endif
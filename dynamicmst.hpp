@@ -0,0 +1,479 @@
+//minimum spanning forest of the surviving network, kept up to date as nodes
+//go down and come back instead of being rebuilt from scratch
+//the forest lives in a link-cut tree where every tree edge is a node of its
+//own carrying the edge's rank, so the most expensive edge on a path is one
+//splay away. Live edges outside the forest sit in buckets by cost
+
+#ifndef DYNAMICMST_H
+#define DYNAMICMST_H
+#include <vector>
+
+/*
+ * Link-cut trees over splay trees with lazy reversal. Every node carries a
+ * key and every splay subtree knows which of its nodes has the largest key,
+ * so pathMax() answers with a node id.
+ */
+class LinkCutForest {
+	private:
+		struct Node {
+			int child[2];
+			int parent;
+			int key;
+			int maxNode;   //node with the largest key in the splay subtree
+			bool flip;
+		};
+		std::vector<Node> nodes;
+		std::vector<int> path;   //scratch for splay
+
+		bool isRoot(int x) const {
+			int p = nodes[x].parent;
+			return p == -1 || (nodes[p].child[0] != x && nodes[p].child[1] != x);
+		}
+		void pull(int x);
+		void push(int x);
+		void rotate(int x);
+		void splay(int x);
+		void access(int x);
+		void makeRoot(int x);
+
+	public:
+		void reset(int numNodes) {
+			nodes.resize(numNodes);
+			path.reserve(numNodes);
+			for(int i = 0; i < numNodes; i++)
+				setKey(i, -1);
+		}
+		//only valid while x is on its own
+		void setKey(int x, int key) {
+			Node& node = nodes[x];
+			node.child[0] = node.child[1] = node.parent = -1;
+			node.key = key;
+			node.maxNode = x;
+			node.flip = false;
+		}
+		int getKey(int x) const { return this->nodes[x].key; }
+
+		int findRoot(int x);
+		bool connected(int x, int y) {  return findRoot(x) == findRoot(y);  }
+		void link(int x, int y);    //x and y in different trees
+		void cut(int x, int y);     //x and y adjacent
+		int pathMax(int x, int y);  //x and y connected
+};
+
+void LinkCutForest::pull(int x) {
+	Node& node = nodes[x];
+	node.maxNode = x;
+	for(int i = 0; i < 2; i++) {
+		int c = node.child[i];
+		if(c != -1 && nodes[nodes[c].maxNode].key > nodes[node.maxNode].key)
+			node.maxNode = nodes[c].maxNode;
+	}
+}
+
+void LinkCutForest::push(int x) {
+	Node& node = nodes[x];
+	if(node.flip) {
+		int temp = node.child[0];
+		node.child[0] = node.child[1];
+		node.child[1] = temp;
+		for(int i = 0; i < 2; i++)
+			if(node.child[i] != -1)
+				nodes[node.child[i]].flip = !nodes[node.child[i]].flip;
+		node.flip = false;
+	}
+}
+
+void LinkCutForest::rotate(int x) {
+	int p = nodes[x].parent;
+	int g = nodes[p].parent;
+	int side = (nodes[p].child[1] == x);
+	int moved = nodes[x].child[!side];
+
+	if(!isRoot(p))
+		nodes[g].child[nodes[g].child[1] == p] = x;
+	nodes[x].parent = g;
+
+	nodes[x].child[!side] = p;
+	nodes[p].parent = x;
+
+	nodes[p].child[side] = moved;
+	if(moved != -1)
+		nodes[moved].parent = p;
+
+	pull(p);
+	pull(x);
+}
+
+void LinkCutForest::splay(int x) {
+	//pending flips are pushed from the top of the splay tree down
+	path.clear();
+	path.push_back(x);
+	for(int y = x; !isRoot(y); y = nodes[y].parent)
+		path.push_back(nodes[y].parent);
+	for(int i = path.size() - 1; i >= 0; i--)
+		push(path[i]);
+
+	while(!isRoot(x)) {
+		int p = nodes[x].parent;
+		if(!isRoot(p)) {
+			int g = nodes[p].parent;
+			bool zigzig = (nodes[g].child[1] == p) == (nodes[p].child[1] == x);
+			rotate(zigzig ? p : x);
+		}
+		rotate(x);
+	}
+}
+
+void LinkCutForest::access(int x) {
+	int last = -1;
+	for(int y = x; y != -1; y = nodes[y].parent) {
+		splay(y);
+		nodes[y].child[1] = last;
+		pull(y);
+		last = y;
+	}
+	splay(x);
+}
+
+void LinkCutForest::makeRoot(int x) {
+	access(x);
+	nodes[x].flip = !nodes[x].flip;
+}
+
+int LinkCutForest::findRoot(int x) {
+	access(x);
+	int root = x;
+	push(root);
+	while(nodes[root].child[0] != -1) {
+		root = nodes[root].child[0];
+		push(root);
+	}
+	splay(root);
+	return root;
+}
+
+void LinkCutForest::link(int x, int y) {
+	makeRoot(x);
+	nodes[x].parent = y;
+}
+
+void LinkCutForest::cut(int x, int y) {
+	makeRoot(x);
+	access(y);
+	//x is now the only node left of y
+	nodes[y].child[0] = -1;
+	nodes[x].parent = -1;
+	pull(y);
+}
+
+int LinkCutForest::pathMax(int x, int y) {
+	makeRoot(x);
+	access(y);
+	return nodes[y].maxNode;
+}
+
+/*
+ * Edges are given once each, sorted by cost, and an edge's position in that
+ * order (its rank) is its key, so ties are broken the same way every time.
+ *
+ * A node coming up offers its live edges to the forest cheapest first: an
+ * edge joining two trees is linked, otherwise it replaces the most expensive
+ * edge on the tree path between its endpoints if it is cheaper.
+ * A node going down cuts its tree edges, which leaves one piece per tree
+ * neighbour. The remaining tree edges stay optimal, so the pieces are
+ * labelled with a walk over the tree and joined again Kruskal style by
+ * scanning the spare edges bucket by bucket, stopping as soon as every
+ * piece that can be reached is joined.
+ *
+ * That scan is O(E) in the worst case for every node going down: a piece
+ * that cannot be reached again, or whose only way back is an expensive
+ * edge, makes it walk every spare edge of the network. There are no per
+ * level replacement lists as in Holm, de Lichtenberg and Thorup, so only
+ * nodeUp() is polylogarithmic per edge. On the dense random networks the
+ * simulator generates the cheapest buckets rejoin the pieces early.
+ */
+class DynamicMST {
+	private:
+		enum EDGE_STATE {
+			EDGE_DEAD = 0,    //an endpoint is down
+			EDGE_SPARE,       //live, not in the forest, in its cost bucket
+			EDGE_TREE
+		};
+
+		int numNodes;
+		std::vector<int> left, right, cost;
+		std::vector<char> state;
+		std::vector<char> up;
+		std::vector<int> offsets, incident;   //edges of every node, cheapest first
+
+		//forest nodes 0 to numNodes - 1 are the nodes, the rest are slots for
+		//tree edges
+		LinkCutForest forest;
+		std::vector<int> edgeSlot, slotEdge, freeSlots;
+		std::vector<std::vector<int> > treeEdges;   //tree edges of every node
+
+		//spare edges by cost
+		std::vector<int> bucketOf, bucketPosition;
+		std::vector<std::vector<int> > buckets;
+
+		long long totalCost;
+		int numTreeEdges;
+
+		//scratch for reconnecting pieces
+		std::vector<int> pieceRoots, pieceParent, label, labelStamp, queue;
+		int stamp;
+
+		int other(int e, int node) const {  return left[e] == node ? right[e] : left[e];  }
+		int findPiece(int piece);
+		void linkEdge(int e);
+		void cutEdge(int e);
+		void addSpare(int e);
+		void removeSpare(int e);
+		void insertEdge(int e);
+		void reconnect();
+
+	public:
+		DynamicMST() : numNodes(0), totalCost(0), numTreeEdges(0), stamp(0) { }
+		//every node starts up
+		void build(int numNodes, const std::vector<int>& left, const std::vector<int>& right,
+			const std::vector<int>& cost);
+
+		void nodeDown(int node);
+		void nodeUp(int node);
+
+		bool isUp(int node) const { return this->up[node]; }
+		long long getCost() const { return this->totalCost; }
+		int getNumTreeEdges() const { return this->numTreeEdges; }
+};
+
+void DynamicMST::build(int numNodes, const std::vector<int>& left, const std::vector<int>& right,
+		const std::vector<int>& cost) {
+	this->numNodes = numNodes;
+	this->left = left;
+	this->right = right;
+	this->cost = cost;
+	int numEdges = cost.size();
+	state.assign(numEdges, EDGE_DEAD);
+	up.assign(numNodes, 1);
+	totalCost = 0;
+	numTreeEdges = 0;
+
+	offsets.assign(numNodes + 1, 0);
+	for(int e = 0; e < numEdges; e++) {
+		offsets[left[e] + 1]++;
+		offsets[right[e] + 1]++;
+	}
+	for(int i = 0; i < numNodes; i++)
+		offsets[i + 1] += offsets[i];
+	incident.resize(offsets[numNodes]);
+	std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+	for(int e = 0; e < numEdges; e++) {
+		incident[fill[left[e]]++] = e;
+		incident[fill[right[e]]++] = e;
+	}
+
+	forest.reset(2 * numNodes);
+	edgeSlot.assign(numEdges, -1);
+	slotEdge.assign(numNodes, -1);
+	freeSlots.clear();
+	for(int slot = numNodes - 1; slot >= 0; slot--)
+		freeSlots.push_back(slot);
+	//every list is sized for its most edges up front, so node changes
+	//never allocate
+	treeEdges.assign(numNodes, std::vector<int>());
+	for(int i = 0; i < numNodes; i++)
+		treeEdges[i].reserve(offsets[i + 1] - offsets[i]);
+
+	bucketOf.resize(numEdges);
+	bucketPosition.assign(numEdges, -1);
+	buckets.clear();
+	for(int e = 0; e < numEdges; e++) {
+		if(e == 0 || cost[e] != cost[e - 1])
+			buckets.push_back(std::vector<int>());
+		bucketOf[e] = buckets.size() - 1;
+	}
+	for(int e = 0, first = 0; e < numEdges; e++)
+		if(e + 1 == numEdges || bucketOf[e + 1] != bucketOf[e]) {
+			buckets[bucketOf[e]].reserve(e + 1 - first);
+			first = e + 1;
+		}
+	pieceRoots.reserve(numNodes);
+	pieceParent.reserve(numNodes);
+	queue.reserve(numNodes);
+
+	label.assign(numNodes, 0);
+	labelStamp.assign(numNodes, 0);
+	stamp = 0;
+
+	//Kruskal for the starting forest
+	std::vector<int> parent(numNodes);
+	for(int i = 0; i < numNodes; i++)
+		parent[i] = i;
+	for(int e = 0; e < numEdges; e++) {
+		int a = left[e], b = right[e];
+		while(parent[a] != a)
+			a = parent[a] = parent[parent[a]];
+		while(parent[b] != b)
+			b = parent[b] = parent[parent[b]];
+		if(a != b) {
+			parent[a] = b;
+			linkEdge(e);
+		} else {
+			addSpare(e);
+		}
+	}
+}
+
+void DynamicMST::linkEdge(int e) {
+	int slot = freeSlots.back();
+	freeSlots.pop_back();
+	edgeSlot[e] = slot;
+	slotEdge[slot] = e;
+	forest.setKey(numNodes + slot, e);
+	forest.link(numNodes + slot, left[e]);
+	forest.link(numNodes + slot, right[e]);
+	treeEdges[left[e]].push_back(e);
+	treeEdges[right[e]].push_back(e);
+	state[e] = EDGE_TREE;
+	totalCost += cost[e];
+	numTreeEdges++;
+}
+
+//the edge is left dead, the caller decides what it becomes
+void DynamicMST::cutEdge(int e) {
+	int slot = edgeSlot[e];
+	forest.cut(numNodes + slot, left[e]);
+	forest.cut(numNodes + slot, right[e]);
+	edgeSlot[e] = -1;
+	freeSlots.push_back(slot);
+	int ends[2] = {left[e], right[e]};
+	for(int i = 0; i < 2; i++) {
+		std::vector<int>& list = treeEdges[ends[i]];
+		for(unsigned int j = 0; j < list.size(); j++)
+			if(list[j] == e) {
+				list[j] = list.back();
+				list.pop_back();
+				break;
+			}
+	}
+	state[e] = EDGE_DEAD;
+	totalCost -= cost[e];
+	numTreeEdges--;
+}
+
+void DynamicMST::addSpare(int e) {
+	std::vector<int>& bucket = buckets[bucketOf[e]];
+	bucketPosition[e] = bucket.size();
+	bucket.push_back(e);
+	state[e] = EDGE_SPARE;
+}
+
+void DynamicMST::removeSpare(int e) {
+	std::vector<int>& bucket = buckets[bucketOf[e]];
+	int last = bucket.back();
+	bucket[bucketPosition[e]] = last;
+	bucketPosition[last] = bucketPosition[e];
+	bucket.pop_back();
+	bucketPosition[e] = -1;
+	state[e] = EDGE_DEAD;
+}
+
+//both endpoints of e are up and e is in neither the forest nor a bucket
+void DynamicMST::insertEdge(int e) {
+	int a = left[e], b = right[e];
+	if(!forest.connected(a, b)) {
+		linkEdge(e);
+		return;
+	}
+	int worst = slotEdge[forest.pathMax(a, b) - numNodes];
+	if(worst > e) {
+		cutEdge(worst);
+		addSpare(worst);
+		linkEdge(e);
+	} else {
+		addSpare(e);
+	}
+}
+
+void DynamicMST::nodeUp(int node) {
+	if(up[node])
+		return;
+	up[node] = 1;
+	for(int i = offsets[node]; i < offsets[node + 1]; i++) {
+		int e = incident[i];
+		if(up[other(e, node)])
+			insertEdge(e);
+	}
+}
+
+void DynamicMST::nodeDown(int node) {
+	if(!up[node])
+		return;
+	up[node] = 0;
+	pieceRoots.clear();
+	for(int i = offsets[node]; i < offsets[node + 1]; i++) {
+		int e = incident[i];
+		if(state[e] == EDGE_TREE) {
+			pieceRoots.push_back(other(e, node));
+			cutEdge(e);
+		} else if(state[e] == EDGE_SPARE) {
+			removeSpare(e);
+		}
+	}
+	if(pieceRoots.size() > 1)
+		reconnect();
+}
+
+int DynamicMST::findPiece(int piece) {
+	while(pieceParent[piece] != piece)
+		piece = pieceParent[piece] = pieceParent[pieceParent[piece]];
+	return piece;
+}
+
+//spare edges only ever join nodes of the same tree, so the only ones that
+//can join two pieces have both endpoints labelled
+void DynamicMST::reconnect() {
+	stamp++;
+	int numPieces = pieceRoots.size();
+	pieceParent.resize(numPieces);
+	for(int piece = 0; piece < numPieces; piece++) {
+		pieceParent[piece] = piece;
+		queue.clear();
+		queue.push_back(pieceRoots[piece]);
+		label[pieceRoots[piece]] = piece;
+		labelStamp[pieceRoots[piece]] = stamp;
+		for(unsigned int head = 0; head < queue.size(); head++) {
+			int node = queue[head];
+			for(unsigned int j = 0; j < treeEdges[node].size(); j++) {
+				int next = other(treeEdges[node][j], node);
+				if(labelStamp[next] != stamp) {
+					labelStamp[next] = stamp;
+					label[next] = piece;
+					queue.push_back(next);
+				}
+			}
+		}
+	}
+
+	int joins = 0;
+	for(unsigned int b = 0; b < buckets.size(); b++) {
+		std::vector<int>& bucket = buckets[b];
+		for(unsigned int i = 0; i < bucket.size(); ) {
+			int e = bucket[i];
+			if(labelStamp[left[e]] == stamp && labelStamp[right[e]] == stamp) {
+				int leftPiece = findPiece(label[left[e]]);
+				int rightPiece = findPiece(label[right[e]]);
+				if(leftPiece != rightPiece) {
+					pieceParent[leftPiece] = rightPiece;
+					removeSpare(e);   //moves the last edge of the bucket to i
+					linkEdge(e);
+					if(++joins == numPieces - 1)
+						return;
+					continue;
+				}
+			}
+			i++;
+		}
+	}
+}
+#endif
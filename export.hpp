@@ -0,0 +1,256 @@
+//graph export for the graph tool
+//every format streams through one reusable output buffer and walks the edge
+//list and the tree edges instead of scanning the n x n matrices, so the
+//time an export takes is linear in the size of what it writes
+
+#ifndef EXPORT_H
+#define EXPORT_H
+#include "graph.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+enum EXPORT_FORMAT {
+	FORMAT_TEXT = 0,    //the original listing: matrix, edge costs, tree
+	FORMAT_MATRIX,      //dense adjacency matrix text
+	FORMAT_CSV,         //edge list
+	FORMAT_DOT,         //graphviz, tree edges in bold
+	FORMAT_BINARY       //fixed width edge list
+};
+
+/*
+ * Output buffer written to a FILE* with fwrite once full, so formatting
+ * never goes through iostreams or a per-value allocation.
+ */
+class ExportBuffer {
+	private:
+		std::FILE* out;
+		std::vector<char> buffer;
+		int used;
+	public:
+		ExportBuffer(std::FILE* out, int capacity = 1 << 20) : out(out), buffer(capacity), used(0) { }
+		~ExportBuffer() {  flush();  }
+		ExportBuffer(const ExportBuffer&) = delete;
+		ExportBuffer& operator=(const ExportBuffer&) = delete;
+
+		void flush() {
+			if(used > 0)
+				std::fwrite(buffer.data(), 1, used, out);
+			used = 0;
+		}
+
+		void put(char c) {
+			if(used == (int)buffer.size())
+				flush();
+			buffer[used++] = c;
+		}
+
+		void write(const void* data, int length) {
+			if(used + length > (int)buffer.size())
+				flush();
+			if(length > (int)buffer.size()) {
+				std::fwrite(data, 1, length, out);
+				return;
+			}
+			std::memcpy(buffer.data() + used, data, length);
+			used += length;
+		}
+
+		void write(const char* text) {  write(text, std::strlen(text));  }
+
+		//decimal, right aligned in width
+		void putInt(long long value, int width = 0);
+
+		void putInt32(int32_t value) {  write(&value, sizeof(value));  }
+};
+
+void ExportBuffer::putInt(long long value, int width) {
+	char digits[24];
+	int length = 0;
+	bool negative = value < 0;
+	unsigned long long magnitude = negative ? 0ULL - (unsigned long long)value : value;
+	do {
+		digits[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while(magnitude);
+	if(negative)
+		digits[length++] = '-';
+
+	char text[48];
+	int pad = (width > length) ? width - length : 0;
+	for(int i = 0; i < pad; i++)
+		text[i] = ' ';
+	for(int i = 0; i < length; i++)
+		text[pad + i] = digits[length - 1 - i];
+	write(text, pad + length);
+}
+
+/*
+ * Endpoint and cost of every edge, with each pair once: as left < right
+ * when that direction exists, otherwise the one way edge a node without
+ * any edge was given, as in Graph::setTrackOptimal(). The tree edges are
+ * in row major order.
+ */
+struct ExportEdges {
+	std::vector<Edge> edges;
+	std::vector<Edge> tree;
+
+	ExportEdges(const Graph& g) {
+		const ArenaVector<Edge>& costEdges = g.getEdges();
+		const int* const* adjMatrix = g.getAdjMatrix();
+		for(unsigned int i = 0; i < costEdges.size(); i++) {
+			const GraphNode* left = costEdges[i].leftNode;
+			const GraphNode* right = costEdges[i].rightNode;
+			if(left->originalName < right->originalName || adjMatrix[right->index][left->index] == 0)
+				edges.push_back(costEdges[i]);
+		}
+
+		//tree edges removed since the last build are zero in the matrix
+		const int* const* spanningTree = g.getSpanningTree();
+		const ArenaVector<Edge*>& treeEdges = g.getTreeEdges();
+		for(unsigned int i = 0; i < treeEdges.size(); i++)
+			if(spanningTree[treeEdges[i]->leftNode->index][treeEdges[i]->rightNode->index] > 0)
+				tree.push_back(*treeEdges[i]);
+		std::sort(tree.begin(), tree.end(), rowMajor);
+	}
+
+	static bool rowMajor(const Edge& lhs, const Edge& rhs) {
+		int l = lhs.leftNode->originalName, r = rhs.leftNode->originalName;
+		return l < r || (l == r && lhs.rightNode->originalName < rhs.rightNode->originalName);
+	}
+};
+
+//every cell 3 wide followed by a space, one row per line
+void exportMatrix(const Graph& g, ExportBuffer& out) {
+	const int* const* adjMatrix = g.getAdjMatrix();
+	int numNodes = g.getNumNodes();
+	for(int i = 0; i < numNodes; i++) {
+		for(int j = 0; j < numNodes; j++) {
+			out.putInt(adjMatrix[g.slot(i)][g.slot(j)], 3);
+			out.put(' ');
+		}
+		out.put('\n');
+	}
+}
+
+//the listing the graph tool has always printed
+void exportText(const Graph& g, ExportBuffer& out) {
+	exportMatrix(g, out);
+
+	const ArenaVector<Edge>& costEdges = g.getEdges();
+	for(unsigned int i = 0; i < costEdges.size(); i++) {
+		out.write("Cost is ");
+		out.putInt(costEdges[i].cost);
+		out.put('\n');
+	}
+
+	out.write("\nSpanning Tree begins \n");
+	ExportEdges edges(g);
+	for(unsigned int i = 0; i < edges.tree.size(); i++) {
+		out.putInt(edges.tree[i].leftNode->originalName);
+		out.write(" node and ");
+		out.putInt(edges.tree[i].rightNode->originalName);
+		out.write(" node has ");
+		out.putInt(edges.tree[i].cost);
+		out.write(" cost.\n");
+	}
+}
+
+//left,right,cost,tree
+void exportCsv(const Graph& g, ExportBuffer& out) {
+	ExportEdges edges(g);
+	const int* const* spanningTree = g.getSpanningTree();
+	out.write("left,right,cost,tree\n");
+	for(unsigned int i = 0; i < edges.edges.size(); i++) {
+		int left = edges.edges[i].leftNode->index;
+		int right = edges.edges[i].rightNode->index;
+		out.putInt(edges.edges[i].leftNode->originalName);
+		out.put(',');
+		out.putInt(edges.edges[i].rightNode->originalName);
+		out.put(',');
+		out.putInt(edges.edges[i].cost);
+		out.write((spanningTree[left][right] > 0 || spanningTree[right][left] > 0) ? ",1\n" : ",0\n");
+	}
+}
+
+void exportDot(const Graph& g, ExportBuffer& out) {
+	ExportEdges edges(g);
+	const int* const* spanningTree = g.getSpanningTree();
+	out.write("graph network {\n");
+	for(int i = 0; i < g.getNumNodes(); i++) {
+		out.write("  ");
+		out.putInt(i);
+		out.write(";\n");
+	}
+	for(unsigned int i = 0; i < edges.edges.size(); i++) {
+		int left = edges.edges[i].leftNode->index;
+		int right = edges.edges[i].rightNode->index;
+		out.write("  ");
+		out.putInt(edges.edges[i].leftNode->originalName);
+		out.write(" -- ");
+		out.putInt(edges.edges[i].rightNode->originalName);
+		out.write(" [label=");
+		out.putInt(edges.edges[i].cost);
+		out.write((spanningTree[left][right] > 0 || spanningTree[right][left] > 0) ? ", style=bold];\n" : "];\n");
+	}
+	out.write("}\n");
+}
+
+/*
+ * Host byte order int32 fields:
+ * "DESG", version, numNodes, numEdges, numTreeEdges, then numEdges
+ * (left, right, cost) records followed by numTreeEdges more for the tree.
+ */
+void exportBinary(const Graph& g, ExportBuffer& out) {
+	ExportEdges edges(g);
+	out.write("DESG", 4);
+	out.putInt32(1);
+	out.putInt32(g.getNumNodes());
+	out.putInt32(edges.edges.size());
+	out.putInt32(edges.tree.size());
+	for(unsigned int i = 0; i < edges.edges.size(); i++) {
+		out.putInt32(edges.edges[i].leftNode->originalName);
+		out.putInt32(edges.edges[i].rightNode->originalName);
+		out.putInt32(edges.edges[i].cost);
+	}
+	for(unsigned int i = 0; i < edges.tree.size(); i++) {
+		out.putInt32(edges.tree[i].leftNode->originalName);
+		out.putInt32(edges.tree[i].rightNode->originalName);
+		out.putInt32(edges.tree[i].cost);
+	}
+}
+
+//false if the format name is unknown
+inline bool parseExportFormat(const char* name, EXPORT_FORMAT& format) {
+	static const char* names[] = {"text", "matrix", "csv", "dot", "binary"};
+	for(int i = 0; i <= FORMAT_BINARY; i++)
+		if(!std::strcmp(name, names[i])) {
+			format = (EXPORT_FORMAT)i;
+			return true;
+		}
+	return false;
+}
+
+void exportGraph(const Graph& g, EXPORT_FORMAT format, ExportBuffer& out) {
+	switch(format) {
+		case FORMAT_TEXT:
+			exportText(g, out);
+			break;
+		case FORMAT_MATRIX:
+			exportMatrix(g, out);
+			break;
+		case FORMAT_CSV:
+			exportCsv(g, out);
+			break;
+		case FORMAT_DOT:
+			exportDot(g, out);
+			break;
+		case FORMAT_BINARY:
+			exportBinary(g, out);
+			break;
+	}
+	out.flush();
+}
+#endif
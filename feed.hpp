@@ -0,0 +1,285 @@
+//external attack feed
+//a producer thread parses attack records from a file or named pipe into a
+//lock-free single producer single consumer ring, and the simulator takes
+//them out one at a time as the attacks it schedules. Neither side allocates
+//per record, a full ring makes the producer wait for the simulator and an
+//empty one puts the simulator to sleep until the producer catches up
+
+#ifndef FEED_H
+#define FEED_H
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+
+//one attack: the target node at a simulated time
+struct AttackRecord {
+	int time;
+	int target;
+};
+
+/*
+ * Ring of a power of two slots shared by exactly one producer and one
+ * consumer thread. head and tail only ever grow; each sits on its own cache
+ * line next to the owner's copy of the other index, which is refreshed only
+ * when that copy makes the ring look full (or empty).
+ */
+template<typename T>
+class SpscRing {
+	private:
+		std::vector<T> slots;
+		uint64_t mask;
+		char pad0[64];
+		std::atomic<uint64_t> head;    //next slot to read, written by the consumer
+		uint64_t cachedTail;
+		char pad1[64];
+		std::atomic<uint64_t> tail;    //next slot to write, written by the producer
+		uint64_t cachedHead;
+		char pad2[64];
+	public:
+		SpscRing(int capacity);
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		//both return false instead of waiting
+		bool tryPush(const T& value);
+		bool tryPop(T& value);
+		int capacity() const { return this->slots.size(); }
+};
+
+template<typename T>
+SpscRing<T>::SpscRing(int capacity) : head(0), cachedTail(0), tail(0), cachedHead(0) {
+	int size = 1;
+	while(size < capacity)
+		size *= 2;
+	slots.resize(size);
+	mask = size - 1;
+}
+
+template<typename T>
+bool SpscRing<T>::tryPush(const T& value) {
+	uint64_t position = tail.load(std::memory_order_relaxed);
+	if(position - cachedHead == slots.size()) {
+		cachedHead = head.load(std::memory_order_acquire);
+		if(position - cachedHead == slots.size())
+			return false;
+	}
+	slots[position & mask] = value;
+	tail.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+bool SpscRing<T>::tryPop(T& value) {
+	uint64_t position = head.load(std::memory_order_relaxed);
+	if(position == cachedTail) {
+		cachedTail = tail.load(std::memory_order_acquire);
+		if(position == cachedTail)
+			return false;
+	}
+	value = slots[position & mask];
+	head.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+/*
+ * Reads "time target" lines, separated by spaces, tabs or a comma, from a
+ * file or named pipe on its own thread. Lines starting with # are comments,
+ * and a line that is not two non-negative integers is counted and skipped.
+ * Opening a named pipe waits for its writer; the feed ends when the writer
+ * closes it. The simulator owns the consumer side through next().
+ */
+class AttackFeed {
+	private:
+		int fd;
+		SpscRing<AttackRecord> ring;
+		std::atomic<bool> done;        //the producer has pushed its last record
+		std::atomic<bool> stopping;    //the consumer is going away
+		std::atomic<bool> sleeping;    //the consumer waits on wakeup
+		std::atomic<bool> producerWaiting;    //the producer waits on room
+		std::mutex wakeMutex;
+		std::condition_variable wakeup;
+		std::mutex roomMutex;
+		std::condition_variable room;
+		long long numRecords;          //producer side, read once done
+		long long numMalformed;
+		std::thread producer;
+
+		void produce();
+		bool push(const AttackRecord& record);
+		void wakeConsumer();
+		void wakeProducer();
+
+	public:
+		static const int DEFAULT_CAPACITY = 1 << 16;
+
+		AttackFeed(const char* path, int capacity = DEFAULT_CAPACITY);
+		~AttackFeed();
+		AttackFeed(const AttackFeed&) = delete;
+		AttackFeed& operator=(const AttackFeed&) = delete;
+
+		bool isOpen() const { return this->fd != -1; }
+
+		//the next record in feed order, sleeping until the producer pushes
+		//one if the ring is empty. False once every record has been taken
+		bool next(AttackRecord& record);
+
+		//only meaningful once next() has returned false
+		long long getNumRecords() const { return this->numRecords; }
+		long long getNumMalformed() const { return this->numMalformed; }
+};
+
+AttackFeed::AttackFeed(const char* path, int capacity) : fd(open(path, O_RDONLY)), ring(capacity),
+	done(false), stopping(false), sleeping(false), producerWaiting(false), numRecords(0), numMalformed(0) {
+	if(fd == -1)
+		done.store(true);
+	else
+		producer = std::thread(&AttackFeed::produce, this);
+}
+
+//a producer still waiting on a pipe's writer keeps the join waiting too
+AttackFeed::~AttackFeed() {
+	stopping.store(true, std::memory_order_relaxed);
+	{
+		//taking the lock waits out a producer between its check and its wait
+		std::lock_guard<std::mutex> lock(roomMutex);
+		room.notify_one();
+	}
+	if(producer.joinable())
+		producer.join();
+}
+
+//sleeps while the ring is full, false if the consumer left meanwhile
+bool AttackFeed::push(const AttackRecord& record) {
+	if(!ring.tryPush(record)) {
+		wakeConsumer();
+		std::unique_lock<std::mutex> lock(roomMutex);
+		producerWaiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		bool pushed = false;
+		room.wait(lock, [&] {
+			pushed = ring.tryPush(record);
+			return pushed || stopping.load(std::memory_order_relaxed);
+		});
+		producerWaiting.store(false, std::memory_order_relaxed);
+		if(!pushed)
+			return false;
+	}
+	numRecords++;
+	return true;
+}
+
+//the fence pairs with the one in next(): either the consumer sees the new
+//tail or done before it sleeps, or this sees it sleeping and wakes it. The
+//lock only comes in when it sleeps. Records are handed over a read buffer
+//at a time, so the producer calls this before every read that can block,
+//on a full ring and at the end, not per record
+void AttackFeed::wakeConsumer() {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(sleeping.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		wakeup.notify_one();
+	}
+}
+
+//the mirror of wakeConsumer(): the fence pairs with the one in push(), so
+//either the producer sees the slot just freed before it sleeps or this sees
+//it waiting and wakes it
+void AttackFeed::wakeProducer() {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(producerWaiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(roomMutex);
+		room.notify_one();
+	}
+}
+
+//parses straight out of the read buffer, a line cut by the end of one read
+//carries its state over to the next
+void AttackFeed::produce() {
+	char buffer[1 << 16];
+	int values[2] = {0, 0};
+	int field = 0;           //values completed on this line
+	long long value = 0;
+	bool inNumber = false;
+	bool bad = false;
+	bool comment = false;
+	bool running = true;
+
+	while(running) {
+		wakeConsumer();
+		ssize_t length = read(fd, buffer, sizeof(buffer));
+		if(length < 0)
+			break;
+		bool end = length == 0;
+		if(end)
+			buffer[length++] = '\n';   //a last line without a newline
+
+		for(ssize_t i = 0; i < length && running; i++) {
+			char c = buffer[i];
+			if(comment) {
+				comment = c != '\n';
+				continue;
+			}
+			if(c >= '0' && c <= '9') {
+				//past INT_MAX the line is rejected and the value stops growing
+				if(value <= INT_MAX)
+					value = value * 10 + (c - '0');
+				bad |= value > INT_MAX;
+				inNumber = true;
+				continue;
+			}
+			if(inNumber) {
+				if(field < 2)
+					values[field] = (int)value;
+				field++;
+				value = 0;
+				inNumber = false;
+			}
+			if(c == '\n') {
+				if(field == 2 && !bad) {
+					AttackRecord record = {values[0], values[1]};
+					running = push(record);
+				} else if(field != 0 || bad) {
+					numMalformed++;
+				}
+				field = 0;
+				bad = false;
+			} else if(c == '#' && field == 0) {
+				comment = true;
+			} else if(c != ' ' && c != '\t' && c != ',' && c != '\r') {
+				bad = true;
+			}
+		}
+		if(end)
+			break;
+	}
+	close(fd);
+	done.store(true, std::memory_order_release);
+	wakeConsumer();
+}
+
+bool AttackFeed::next(AttackRecord& record) {
+	bool popped = ring.tryPop(record);
+	if(!popped) {
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		wakeup.wait(lock, [&] {
+			popped = ring.tryPop(record);
+			return popped || done.load(std::memory_order_acquire);
+		});
+		sleeping.store(false, std::memory_order_relaxed);
+
+		//a record pushed right before done was set is still in the ring
+		popped = popped || ring.tryPop(record);
+	}
+	if(popped)
+		wakeProducer();
+	return popped;
+}
+#endif
@@ -5,17 +5,33 @@
 #define GRAPH_H
 #include <random>
 #include <vector>
-#include <queue> //priority_queue and queue
+#include <queue> //queue
+#include <algorithm> //stable_sort
 #include <stack>
 #include <iostream> //cout
-
+#include "stats.hpp"
+#include "routing.hpp"
+#include "nodeset.hpp"
+#include "dynamicmst.hpp"
+#include "arena.hpp"
+#include "mstcache.hpp"
+
+//compromised/affected state and current union find names are kept by the
+//Graph in dense arrays indexed by index, the node's slot. index is the same
+//as originalName unless the Graph reordered its nodes, originalName is the
+//id everything outside the Graph sees. A Graph's nodes and their
+//containers live in its arena. adjNodes gains both ends of every edge a
+//build unions and namePathStack an entry for every union of the node's
+//set, and neither is trimmed until a reorder, so both grow with the number
+//of rebuilds in a run and have no bound to size them by up front
 struct GraphNode {
-	bool compromised;
-	bool affected;
-	std::stack<int> namePathStack;
-	std::vector<GraphNode*> adjNodes;
-	int currentName;
+	std::stack<int, ArenaVector<int> > namePathStack;
+	ArenaVector<GraphNode*> adjNodes;
 	int originalName;
+	int index;
+
+	GraphNode() : originalName(0), index(0) { }
+	GraphNode(Arena* arena) : namePathStack(ArenaVector<int>(arena)), adjNodes(arena), originalName(0), index(0) { }
 };
 
 struct Edge {
@@ -28,41 +44,177 @@ struct Edge {
 	}
 };
 
-//To use priority queue
-struct LessThanCost {
-	bool operator()(const Edge* lhs, const Edge* rhs) {
-		return lhs->cost > rhs->cost;
+//orders edge indices by cost
+struct EdgeCostOrder {
+	const ArenaVector<Edge>& edges;
+	EdgeCostOrder(const ArenaVector<Edge>& edges) : edges(edges) { }
+	bool operator()(int lhs, int rhs) const {
+		return edges[lhs].cost < edges[rhs].cost;
 	}
 };
 
-//Define Graph class
+//reverse Cuthill-McKee order of the network: breadth first from a lowest
+//degree node, neighbours taken lowest degree first, then reversed. Returns
+//the node to put in each slot
+inline std::vector<int> reverseCuthillMcKee(const int* const* adjMatrix, int numNodes) {
+	std::vector<std::vector<int> > neighbours(numNodes);
+	for(int i = 0; i < numNodes; i++)
+		for(int j = 0; j < i; j++)
+			if(adjMatrix[i][j] != 0 || adjMatrix[j][i] != 0) {
+				neighbours[i].push_back(j);
+				neighbours[j].push_back(i);
+			}
+	std::vector<int> byDegree(numNodes);
+	for(int i = 0; i < numNodes; i++)
+		byDegree[i] = i;
+	struct DegreeOrder {
+		const std::vector<std::vector<int> >& neighbours;
+		bool operator()(int lhs, int rhs) const {
+			return neighbours[lhs].size() < neighbours[rhs].size();
+		}
+	} degreeOrder = {neighbours};
+	std::stable_sort(byDegree.begin(), byDegree.end(), degreeOrder);
+	for(int i = 0; i < numNodes; i++)
+		std::stable_sort(neighbours[i].begin(), neighbours[i].end(), degreeOrder);
+
+	std::vector<int> order;
+	order.reserve(numNodes);
+	std::vector<bool> placed(numNodes, false);
+	for(int k = 0; k < numNodes; k++) {
+		if(placed[byDegree[k]])
+			continue;
+		placed[byDegree[k]] = true;
+		order.push_back(byDegree[k]);
+		for(unsigned int head = order.size() - 1; head < order.size(); head++) {
+			const std::vector<int>& next = neighbours[order[head]];
+			for(unsigned int i = 0; i < next.size(); i++)
+				if(!placed[next[i]]) {
+					placed[next[i]] = true;
+					order.push_back(next[i]);
+				}
+		}
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
 using mt1337 = std::mt19937; 
+
+//the random network of a seed, row by row. rowOf(i) is where row i goes, or
+//nullptr for a row the caller does not keep, and every row is drawn either
+//way since one draw sets a cell on each side of the diagonal. Costs are
+//drawn from -120..100 and the non-positive ones dropped, a node left
+//without an edge gets one costing 1..100. 0 where there is no edge
+template<typename RowOf>
+void randomNetworkRows(int numNodes, int seed, RowOf rowOf) {
+	mt1337 mt(seed);
+	std::uniform_int_distribution<int> uniform(1, 100);
+	std::uniform_int_distribution<int> cost(-120, 100);
+	std::vector<bool> positive(numNodes, false);
+	for (int i = 0; i < numNodes; i++) {
+		auto* row = rowOf(i);
+		if (row)
+			row[i] = 0;
+		for (int j = 0; j < i; j++) {
+			int value = cost(mt);
+			auto* column = rowOf(j);
+			if (row)
+				row[j] = value;
+			if (column)
+				column[i] = value;
+			if (value > 0)
+				positive[i] = positive[j] = true;
+		}
+	}
+
+	//a row without an edge links to its first largest cell, or to nothing
+	//when that is the diagonal
+	for (int i = 0; i < numNodes; i++) {
+		int extra = positive[i] ? 0 : uniform(mt);
+		auto* row = rowOf(i);
+		if (!row)
+			continue;
+		int maxIndex = 0;
+		for (int j = 0; j < numNodes; j++)
+			if (row[j] > row[maxIndex])
+				maxIndex = j;
+		for (int j = 0; j < numNodes; j++)
+			if (row[j] < 0)
+				row[j] = 0;
+		if (!positive[i] && maxIndex != i)
+			row[maxIndex] = extra;
+	}
+}
+
+inline void randomNetwork(int* const* adjMatrix, int numNodes, int seed) {
+	randomNetworkRows(numNodes, seed, [adjMatrix](int i) { return adjMatrix[i]; });
+}
+
+//Define Graph class
 class Graph {
   private:
 		int numNodes;
-		std::vector<Edge> costEdges;
-		std::vector<Edge> fakeEdges;
+
+		//backs everything below that grows with the graph, sized up front so
+		//construction is a few large blocks and teardown frees only those
+		Arena arena;
+		static std::size_t nodeBytes(int numNodes);
+		static std::size_t edgeBytes(int numEdges);
+
+		//node state, downNodes is compromisedNodes | affectedNodes
+		NodeSet compromisedNodes;
+		NodeSet affectedNodes;
+		NodeSet downNodes;
+		uint64_t downHash;           //xor of zobristKey over downNodes
+		ArenaVector<int> slots;      //slot of each originalName
+		ArenaVector<int> names;      //current union find name of each node
+		ArenaVector<int> fakeNames;  //same for the fake MST
+
+		//edges sorted by cost (equal costs in edge list order), costEdges
+		//index and endpoints of the k-th cheapest edge for bulk tests
+		ArenaVector<int> edgeOrder;
+		ArenaVector<int> edgeLeft;
+		ArenaVector<int> edgeRight;
+
+		//scratch for the scan kernels
+		ArenaVector<int> liveEdges;
+		ArenaVector<int> matches;
+		ArenaVector<int> seenNames;  //componentCount()
+
+		ArenaVector<Edge> costEdges;
+		ArenaVector<Edge> fakeEdges;
 		GraphNode* fakeNodes;
 		int** fakeTree;
+		//sorted edge positions set in fakeTree and their total, so the fake
+		//tree is cleared and reported without scanning the matrix
+		std::vector<int> fakeTreeEdges;
+		long long fakeCost;
+		ForestCache optimalCache;
 		int** spanningTree;
     int** adjMatrix;
 
-	//Control the randomness 
-    mt1337 mt;
-    std::uniform_int_distribution<int> uniform;
-    std::uniform_int_distribution<int> cost;
-    int getRandCost() {
-			return this->cost(this->mt);
-		}		
-		//If all cost values are negative, use random uniform funciton
-    int getRandUniform() {
-      return this->uniform(this->mt);
-    }
+		//edges currently in spanningTree, and routes over them
+		ArenaVector<Edge*> treeEdges;
+		RoutingTable routes;
+		bool routesStale;
+
+		//scratch for missingNodes()
+		std::vector<int> missing;
+
+		//uncompromised nodes by originalName, kept when attackers only pick
+		//live targets
+		bool trackLive;
+		NodeSampler liveNodes;
+
+		//optimal forest kept up to date on every attack and fix
+		bool trackOptimal;
+		DynamicMST dynamicOptimal;
+		void nodeDown(int node);
+		void nodeUp(int node);
 
 		//build spanning tree with union find 
-		std::priority_queue<Edge*,std::vector<Edge*>,LessThanCost> pq;
 		void build();
-		void unionSet(GraphNode* leftNode, GraphNode* rightNode);
+		void unionSet(GraphNode* set, ArenaVector<int>& setNames, GraphNode* leftNode, GraphNode* rightNode);
 
 		//methods if the tree has been affected 
 		void affected(GraphNode* target);
@@ -72,79 +224,136 @@ class Graph {
 		//fake MST
 		void fakeBuild();
 		void fakeReset();
+		void fakeRestore(const CachedForest& forest);
+
+		//benchmarks time the private build steps
+		friend struct GraphBench;
 
   public:
 	GraphNode* nodes;
     Graph(int numNodes, int seed);
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+	//matrices are indexed by GraphNode::index, slot() maps an originalName
+	//to it. Every other method taking a node takes its originalName
     const int* const* getAdjMatrix() const { return this->adjMatrix; }
 	const int* const* getSpanningTree() const { return this->spanningTree; }
-	const std::vector<Edge> getEdges() const { return this->costEdges; }
+	int slot(int node) const { return this->slots[node]; }
+	GraphNode* getNode(int node) { return &this->nodes[this->slots[node]]; }
+	const ArenaVector<Edge>& getEdges() const { return this->costEdges; }
+	//may still hold edges removed since the last build, which are zero in
+	//getSpanningTree()
+	const ArenaVector<Edge*>& getTreeEdges() const { return this->treeEdges; }
 	const int getNumNodes() const { return this->numNodes; }
+	int getCost(int i, int j) const { return this->adjMatrix[slots[i]][slots[j]]; }
+	void lowerEdges(std::vector<std::pair<int, int> >& edges) const;
     void changeNode(int i, int j, int newValue) {
-      this->adjMatrix[i][j] = this->adjMatrix[j][i] = newValue;
+      this->adjMatrix[slots[i]][slots[j]] = this->adjMatrix[slots[j]][slots[i]] = newValue;
     }
 
+		//Relabel the nodes for locality, only before the first attack
+		void reorderNodes();
+
 		//Rebuild spanning tree
 		void rebuild();
 
+		//Routing over the current spanning forest, queried by originalName.
+		//Any change to the tree marks it stale and the first query after
+		//rebuilds the whole table, O(n log n)
+		const RoutingTable& getRoutes();
+
 		//Attacked and fixed
 		void attacked(GraphNode* target);
 		void fixed(GraphNode* target);
 		bool partitioned();
+		int componentCount();
+		bool isCompromised(int node) const { return this->compromisedNodes.test(slots[node]); }
+		bool isAffected(int node) const { return this->affectedNodes.test(slots[node]); }
+		bool isDown(int node) const { return this->downNodes.test(slots[node]); }
+		int getCurrentName(int node) const { return this->nodes[names[slots[node]]].originalName; }
+
+		//Uncompromised nodes to attack, off by default
+		void setTrackLive(bool track);
+		int numLiveTargets() const { return this->liveNodes.size(); }
+		int liveTarget(int index) const { return this->liveNodes.at(index); }
+
+		//Optimal cost after every change, off by default
+		void setTrackOptimal(bool track);
+		long long currentOptimalCost() const { return this->dynamicOptimal.getCost(); }
+
+		//Optimal forests remembered by down set, 0 entries turns it off
+		static const int DEFAULT_OPTIMAL_CACHE = 64;
+		void setOptimalCache(int entries) { this->optimalCache.setCapacity(entries); }
+		const ForestCache& getOptimalCache() const { return this->optimalCache; }
+
+		//Memory held by the graph's arena
+		const Arena& getArena() const { return this->arena; }
+
+		//Rebuild report
+		long long spanningTreeCost() const;
+		long long optimalCost() const;
+		const std::vector<int>& missingNodes();
 };
 
-Graph::Graph(int numNodes, int seed) : uniform(1, 100), cost(-120, 100) {
+//nodes, matrices and the per node arrays
+std::size_t Graph::nodeBytes(int numNodes) {
+	std::size_t n = numNodes;
+	std::size_t bytes = 2 * n * sizeof(GraphNode)
+		+ 3 * (n * sizeof(int*) + n * n * sizeof(int))
+		+ 5 * n * sizeof(int)
+		+ n * sizeof(Edge*);
+	return bytes + 16 * 64;  //alignment of each array
+}
+
+//edge lists and the sorted edge arrays
+std::size_t Graph::edgeBytes(int numEdges) {
+	std::size_t m = numEdges;
+	return 2 * m * sizeof(Edge) + 4 * m * sizeof(int) + 8 * 64;
+}
+
+Graph::Graph(int numNodes, int seed) : arena(nodeBytes(numNodes)),
+	compromisedNodes(numNodes), affectedNodes(numNodes), downNodes(numNodes), downHash(0),
+	slots(numNodes, 0, &arena), names(numNodes, 0, &arena), fakeNames(numNodes, 0, &arena), edgeOrder(&arena),
+	edgeLeft(&arena), edgeRight(&arena), liveEdges(&arena), matches(numNodes, 0, &arena), seenNames(numNodes, 0, &arena),
+	costEdges(&arena), fakeEdges(&arena), fakeCost(0), optimalCache(DEFAULT_OPTIMAL_CACHE, numNodes), treeEdges(&arena),
+	routesStale(true), trackLive(false), trackOptimal(false) {
 	//initialize nodes;
 	this->numNodes = numNodes;
-	nodes = new GraphNode[numNodes];
+	nodes = arena.allocateArray<GraphNode>(numNodes);
+	fakeNodes = arena.allocateArray<GraphNode>(numNodes);
 	for (int i = 0; i < numNodes; i++) {
-		nodes[i].originalName = nodes[i].currentName = i;
+		new (&nodes[i]) GraphNode(&arena);
+		new (&fakeNodes[i]) GraphNode(&arena);
+		nodes[i].originalName = nodes[i].index = slots[i] = names[i] = i;
 		nodes[i].namePathStack.push(i);
+
+		fakeNodes[i].originalName = fakeNodes[i].index = fakeNames[i] = i;
+		fakeNodes[i].namePathStack.push(i);
 	}
 	
-	//initialize cost matrix
-  this->mt.seed(seed);
-  this->adjMatrix = new int*[numNodes];
-	this->spanningTree = new int*[numNodes];
-	this->fakeTree = new int*[numNodes];
-  for (int i = 0; i < numNodes; i++) {
-    this->adjMatrix[i] = new int[numNodes];
-		this->spanningTree[i] = new int[numNodes];
-		this->fakeTree[i] = new int[numNodes];
-  }
-
-  for (int i = 0; i < numNodes; i++) {
-    for (int j = 0; j < i; j++) {
-      this->adjMatrix[j][i] = this->adjMatrix[i][j] = getRandCost();
-			this->spanningTree[j][i] = this->spanningTree[i][j] = 0;
-			this->fakeTree[j][i] = this->fakeTree[i][j] = 0;
-    }
-  }
-
-  for (int i = 0; i < numNodes; i++) {
-    int max = -1337;
-    int maxIndex = -1337;
-    for (int j = 0; j < numNodes; j++) {
-      if (this->adjMatrix[i][j] > max) {
-        max = this->adjMatrix[i][j];
-        maxIndex = j;
-      }
-      if (this->adjMatrix[i][j] <= 0) {
-        this->adjMatrix[i][j] = -1337;
-      }
-    }
-    if (max <= 0) {
-      this->adjMatrix[i][maxIndex] = this->getRandUniform();
-    }
-  }
+	//each matrix is one block with its rows back to back
+	int*** matrices[3] = {&adjMatrix, &spanningTree, &fakeTree};
+	for (int k = 0; k < 3; k++) {
+		*matrices[k] = arena.allocateArray<int*>(numNodes);
+		int* cells = arena.allocateArray<int>((std::size_t)numNodes * numNodes);
+		std::fill(cells, cells + (std::size_t)numNodes * numNodes, 0);
+		for (int i = 0; i < numNodes; i++)
+			(*matrices[k])[i] = cells + (std::size_t)i * numNodes;
+	}
+	treeEdges.reserve(numNodes);
+	fakeTreeEdges.reserve(numNodes);
+	missing.reserve(numNodes);
 
-  for (int i = 0; i < numNodes; i++) {
-    for (int j = 0; j < numNodes; j++) {
-      if (this->adjMatrix[i][j] == -1337 || i == j) {
-        this->adjMatrix[i][j] = 0;
-      }
-    }
-  }
+	randomNetwork(adjMatrix, numNodes, seed);
+
+	int numEdges = 0;
+	for (int i = 0; i < numNodes; i++)
+		for (int j = 0; j < numNodes; j++)
+			if (this->adjMatrix[i][j] != 0)
+				numEdges++;
+	arena.reserve(edgeBytes(numEdges));
+	costEdges.reserve(numEdges);
+	fakeEdges.reserve(numEdges);
 
 	for (int i = 0; i < numNodes; i++) {
 		for (int j = 0; j < numNodes; j++) {
@@ -164,125 +373,168 @@ Graph::Graph(int numNodes, int seed) : uniform(1, 100), cost(-120, 100) {
 		}
 	}
 
+	//costs never change, so the edges are sorted once here instead of
+	//going through a priority queue on every build
+	edgeOrder.resize(costEdges.size());
+	for(unsigned int k = 0; k < edgeOrder.size(); k++)
+		edgeOrder[k] = k;
+	std::stable_sort(edgeOrder.begin(), edgeOrder.end(), EdgeCostOrder(costEdges));
+	edgeLeft.resize(costEdges.size());
+	edgeRight.resize(costEdges.size());
+	for(unsigned int k = 0; k < edgeOrder.size(); k++) {
+		edgeLeft[k] = costEdges[edgeOrder[k]].leftNode->index;
+		edgeRight[k] = costEdges[edgeOrder[k]].rightNode->index;
+	}
+	liveEdges.resize(costEdges.size());
+
 	build();
 }
 
 void Graph::build() {
-	//sort first
-	for (unsigned int i = 0; i < costEdges.size(); i++) {
-		pq.push(&costEdges[i]);
-	}
+	//drop the tree edges removed since the last build
+	unsigned int kept = 0;
+	for(unsigned int i = 0; i < treeEdges.size(); i++)
+		if(spanningTree[treeEdges[i]->leftNode->index][treeEdges[i]->rightNode->index] != 0)
+			treeEdges[kept++] = treeEdges[i];
+	treeEdges.resize(kept);
+	routesStale = true;
+
+	//edges touching a compromised or affected node never qualify, the rest
+	//come out cheapest first
+	int numLive = selectLiveEdges(downNodes, edgeLeft.data(), edgeRight.data(), costEdges.size(), liveEdges.data());
 
 	Edge* tempEdge;
 	int leftIndex;
 	int rightIndex;
-	int leftNodeName;
-	int rightNodeName;
-	int queueSize = pq.size();
-	for (int i = 0; i < queueSize; i++) {
-		tempEdge = pq.top();
-		leftIndex = tempEdge->leftNode->originalName;
-		rightIndex = tempEdge->rightNode->originalName;
-		leftNodeName = tempEdge->leftNode->currentName;
-		rightNodeName = tempEdge->rightNode->currentName;
-		pq.pop();
-		
-		//add condition that Node is not compromised
-		if((leftNodeName != rightNodeName) &&
-			!tempEdge->leftNode->compromised &&
-			!tempEdge->leftNode->affected &&
-			!tempEdge->rightNode->compromised &&
-			!tempEdge->rightNode->affected) {
-			unionSet(tempEdge->leftNode, tempEdge->rightNode);
+	for (int i = 0; i < numLive; i++) {
+		tempEdge = &costEdges[edgeOrder[liveEdges[i]]];
+		leftIndex = edgeLeft[liveEdges[i]];
+		rightIndex = edgeRight[liveEdges[i]];
+
+		if(names[leftIndex] != names[rightIndex]) {
+			unionSet(nodes, names, tempEdge->leftNode, tempEdge->rightNode);
+			if(spanningTree[leftIndex][rightIndex] == 0)
+				treeEdges.push_back(tempEdge);
 			spanningTree[leftIndex][rightIndex] = tempEdge->cost;
 		}
 	}
 }
 
 void Graph::fakeBuild() {
-	for (unsigned int i = 0; i < fakeEdges.size(); i++) {
-		pq.push(&fakeEdges[i]);
-	}
+	//fake nodes share the state of the real nodes
+	int numLive = selectLiveEdges(downNodes, edgeLeft.data(), edgeRight.data(), fakeEdges.size(), liveEdges.data());
 
 	Edge* tempEdge;
 	int leftIndex;
 	int rightIndex;
-	int leftNodeName;
-	int rightNodeName;
-	int queueSize = pq.size();
-	for(int i = 0; i < queueSize; i++) {
-		tempEdge = pq.top();
-		leftIndex = tempEdge->leftNode->originalName;
-		rightIndex = tempEdge->rightNode->originalName;
-		leftNodeName = tempEdge->leftNode->currentName;
-		rightNodeName = tempEdge->rightNode->currentName;
-		pq.pop();
-		
-		//add condition that Node is not compromised
-		if((leftNodeName != rightNodeName) &&
-			!tempEdge->leftNode->compromised &&
-			!tempEdge->leftNode->affected &&
-			!tempEdge->rightNode->compromised &&
-			!tempEdge->rightNode->affected) {
-			unionSet(tempEdge->leftNode, tempEdge->rightNode);
+	for(int i = 0; i < numLive; i++) {
+		tempEdge = &fakeEdges[edgeOrder[liveEdges[i]]];
+		leftIndex = edgeLeft[liveEdges[i]];
+		rightIndex = edgeRight[liveEdges[i]];
+
+		if(fakeNames[leftIndex] != fakeNames[rightIndex]) {
+			unionSet(fakeNodes, fakeNames, tempEdge->leftNode, tempEdge->rightNode);
 			fakeTree[leftIndex][rightIndex] = tempEdge->cost;
+			fakeTreeEdges.push_back(liveEdges[i]);
+			fakeCost += tempEdge->cost;
 		}
 	}
 }
 
 void Graph::fakeReset() {
+	for(int i = 0; i < numNodes; i++)
+		fakeNames[i] = i;
 	for(int i = 0; i < numNodes; i++) {
-		fakeNodes[i].currentName = fakeNodes[i].originalName;
+		fakeNodes[i].adjNodes.clear();
+		while(fakeNodes[i].namePathStack.size() > 1)
+			fakeNodes[i].namePathStack.pop();
 	}
 
-	for(int i = 0; i < numNodes; i++) 
-		for(int j = 0; j < numNodes; j++) 
-			spanningTree[i][j] = 0;
+	for(unsigned int i = 0; i < fakeTreeEdges.size(); i++)
+		fakeTree[edgeLeft[fakeTreeEdges[i]]][edgeRight[fakeTreeEdges[i]]] = 0;
+	fakeTreeEdges.clear();
+	fakeCost = 0;
+}
+
+//puts a cached forest in fakeTree, the fake union find is left as it is
+//since fakeReset() starts it over before the next fakeBuild()
+void Graph::fakeRestore(const CachedForest& forest) {
+	for(unsigned int i = 0; i < fakeTreeEdges.size(); i++)
+		fakeTree[edgeLeft[fakeTreeEdges[i]]][edgeRight[fakeTreeEdges[i]]] = 0;
+	fakeTreeEdges = forest.edges;
+	fakeCost = forest.cost;
+	for(unsigned int i = 0; i < fakeTreeEdges.size(); i++) {
+		int k = fakeTreeEdges[i];
+		fakeTree[edgeLeft[k]][edgeRight[k]] = fakeEdges[edgeOrder[k]].cost;
+	}
 }
 
-void Graph::unionSet(GraphNode* leftNode, GraphNode* rightNode) {
+//set is the node array (real or fake) both nodes belong to, setNames its names
+void Graph::unionSet(GraphNode* set, ArenaVector<int>& setNames, GraphNode* leftNode, GraphNode* rightNode) {
 	//Print before union
 	//std::cout << "Before : " << std::endl;
-	//std::cout << "Left node's original Name is " << leftNode->originalName << " and " << "current name is " << leftNode->currentName << std::endl;
-	//std::cout << "Right node's original Name is " << rightNode->originalName << " and " << "current name is " << rightNode->currentName << std::endl;
+	//std::cout << "Left node's original Name is " << leftNode->originalName << " and " << "current name is " << setNames[leftNode->originalName] << std::endl;
+	//std::cout << "Right node's original Name is " << rightNode->originalName << " and " << "current name is " << setNames[rightNode->originalName] << std::endl;
 
 	leftNode->adjNodes.push_back(rightNode);
 	rightNode->adjNodes.push_back(leftNode);
 
-	//Union Set
-	int leftNodeName = leftNode->currentName;
-	int rightNodeName = rightNode->currentName;
-	
-	if(leftNodeName < rightNodeName) {
-		for(int i = 0; i < numNodes; i++) {
-			if(nodes[i].currentName == rightNodeName) {
-				nodes[i].currentName = leftNodeName;
-				nodes[i].namePathStack.push(leftNode->originalName);
-			}
-		}
-	}	else {
-		for(int i = 0; i < numNodes; i++) {
-			if(nodes[i].currentName == leftNodeName) {
-				nodes[i].currentName = rightNodeName;
-				nodes[i].namePathStack.push(rightNode->originalName);
-			}
-		}
+	//Union Set, the larger name is relabelled to the smaller one, compared
+	//by originalName so reordering the nodes picks the same names
+	int leftNodeName = setNames[leftNode->index];
+	int rightNodeName = setNames[rightNode->index];
+	int oldName = rightNodeName;
+	int newName = leftNodeName;
+	int via = leftNode->index;
+	if(set[leftNodeName].originalName >= set[rightNodeName].originalName) {
+		oldName = leftNodeName;
+		newName = rightNodeName;
+		via = rightNode->index;
+	}
+
+	int found = findEqual(setNames.data(), numNodes, oldName, matches.data());
+	for(int i = 0; i < found; i++) {
+		setNames[matches[i]] = newName;
+		set[matches[i]].namePathStack.push(via);
 	}
 }
 
+//fake MST is left in fakeTree until the next rebuild so it can be reported
 void Graph::rebuild() {
-	build();
-	fakeBuild();
-	fakeReset();
+	{
+		STATS_TIME_REPAIR();
+		build();
+	}
+	{
+		STATS_TIME_OPTIMAL();
+		const CachedForest* cached = optimalCache.find(downHash, downNodes);
+		STATS_OPTIMAL_CACHE(cached != nullptr);
+		if(cached) {
+			fakeRestore(*cached);
+		} else {
+			fakeReset();
+			fakeBuild();
+			optimalCache.insert(downHash, downNodes, fakeCost, fakeTreeEdges);
+		}
+	}
 }
 
 void Graph::fixed(GraphNode* target) {
-	target->compromised = false;
-	target->affected = false;
+	STATS_TIME_OP(OP_FIXED);
+	int index = target->index;
+	compromisedNodes.reset(index);
+	affectedNodes.reset(index);
+	if(trackLive)
+		liveNodes.insert(target->originalName);
+	nodeUp(index);
 }
 
 void Graph::attacked(GraphNode* target) {
-	target->compromised = true; //compromised
+	STATS_TIME_OP(OP_ATTACKED);
+	compromisedNodes.set(target->index); //compromised
+	if(trackLive)
+		liveNodes.erase(target->originalName);
+	nodeDown(target->index);
 	for(unsigned int i = 0; i < target->adjNodes.size();i++) {
 		this->affected(target->adjNodes[i]);
 	}
@@ -296,43 +548,168 @@ void Graph::attacked(GraphNode* target) {
 
 void Graph::affected(GraphNode* target) {
 	//std::cout << "Affected" << std::endl;
-	target->affected = true;
+	affectedNodes.set(target->index);
+	nodeDown(target->index);
 
 	this->removeFromTree(target);
 	this->rename(target);
 }
 
+void Graph::nodeDown(int node) {
+	if(downNodes.test(node))
+		return;
+	downNodes.set(node);
+	downHash ^= zobristKey(node);
+	if(trackOptimal)
+		dynamicOptimal.nodeDown(node);
+}
+
+void Graph::nodeUp(int node) {
+	if(!downNodes.test(node))
+		return;
+	downNodes.reset(node);
+	downHash ^= zobristKey(node);
+	if(trackOptimal)
+		dynamicOptimal.nodeUp(node);
+}
+
+void Graph::setTrackLive(bool track) {
+	if(track && !trackLive) {
+		liveNodes = NodeSampler(numNodes);
+		for(int i = 0; i < numNodes; i++)
+			if(!compromisedNodes.test(slots[i]))
+				liveNodes.insert(i);
+	}
+	trackLive = track;
+}
+
+//the edge list holds both directions of most pairs, the dynamic forest
+//takes each pair once in cost order
+void Graph::setTrackOptimal(bool track) {
+	if(track && !trackOptimal) {
+		std::vector<int> left, right, cost;
+		for(unsigned int k = 0; k < edgeOrder.size(); k++) {
+			int i = edgeLeft[k], j = edgeRight[k];
+			if(i < j || adjMatrix[j][i] == 0) {
+				left.push_back(i);
+				right.push_back(j);
+				cost.push_back(costEdges[edgeOrder[k]].cost);
+			}
+		}
+		dynamicOptimal.build(numNodes, left, right, cost);
+		std::vector<int> down;
+		downNodes.list(down);
+		for(unsigned int i = 0; i < down.size(); i++)
+			dynamicOptimal.nodeDown(down[i]);
+	}
+	trackOptimal = track;
+}
+
+//moves every node to its reverse Cuthill-McKee slot, so nodes that share
+//edges sit close together in the per node arrays and matrices. The edge
+//list keeps its order, which keeps cost ties and so every tree the same
+void Graph::reorderNodes() {
+	std::vector<int> order = reverseCuthillMcKee(adjMatrix, numNodes);
+	std::vector<int> position(numNodes);
+	for(int s = 0; s < numNodes; s++)
+		position[order[s]] = s;
+
+	//clear the trees while their cells are still where the lists say
+	for(unsigned int i = 0; i < treeEdges.size(); i++)
+		spanningTree[treeEdges[i]->leftNode->index][treeEdges[i]->rightNode->index] = 0;
+	treeEdges.clear();
+	fakeReset();
+
+	std::vector<int> cells((std::size_t)numNodes * numNodes);
+	for(int s = 0; s < numNodes; s++)
+		for(int t = 0; t < numNodes; t++)
+			cells[(std::size_t)s * numNodes + t] = adjMatrix[order[s]][order[t]];
+	for(int s = 0; s < numNodes; s++)
+		std::copy(cells.begin() + (std::size_t)s * numNodes, cells.begin() + (std::size_t)(s + 1) * numNodes, adjMatrix[s]);
+
+	for(unsigned int k = 0; k < costEdges.size(); k++) {
+		costEdges[k].leftNode = &nodes[position[costEdges[k].leftNode->index]];
+		costEdges[k].rightNode = &nodes[position[costEdges[k].rightNode->index]];
+		fakeEdges[k].leftNode = &fakeNodes[position[fakeEdges[k].leftNode->index]];
+		fakeEdges[k].rightNode = &fakeNodes[position[fakeEdges[k].rightNode->index]];
+	}
+
+	std::vector<int> original(numNodes);
+	for(int s = 0; s < numNodes; s++)
+		original[s] = nodes[order[s]].originalName;
+	for(int s = 0; s < numNodes; s++) {
+		GraphNode* both[2] = {&nodes[s], &fakeNodes[s]};
+		for(int k = 0; k < 2; k++) {
+			both[k]->originalName = original[s];
+			both[k]->index = s;
+			both[k]->adjNodes.clear();
+			while(!both[k]->namePathStack.empty())
+				both[k]->namePathStack.pop();
+			both[k]->namePathStack.push(s);
+		}
+		slots[original[s]] = s;
+		names[s] = fakeNames[s] = s;
+	}
+
+	for(unsigned int k = 0; k < edgeOrder.size(); k++) {
+		edgeLeft[k] = costEdges[edgeOrder[k]].leftNode->index;
+		edgeRight[k] = costEdges[edgeOrder[k]].rightNode->index;
+	}
+	optimalCache.clear();
+	if(trackOptimal) {
+		trackOptimal = false;
+		setTrackOptimal(true);
+	}
+	build();
+}
+
 void Graph::removeFromTree(GraphNode* target) {
 	//std::cout << "Remove From Tree" << std::endl;
-	int index = target->originalName;
+	int index = target->index;
 	for(int i = 0; i < numNodes; i++)
 		for(int j = 0; j < numNodes; j++)
 			if(i == index||j == index)
 				spanningTree[i][j] = 0;
+	routesStale = true;
+}
+
+const RoutingTable& Graph::getRoutes() {
+	if(routesStale) {
+		routes.reset(numNodes);
+		for(unsigned int i = 0; i < treeEdges.size(); i++) {
+			Edge* edge = treeEdges[i];
+			if(spanningTree[edge->leftNode->index][edge->rightNode->index] != 0)
+				routes.addLink(edge->leftNode->originalName, edge->rightNode->originalName, edge->cost);
+		}
+		routes.finish();
+		routesStale = false;
+	}
+	return routes;
 }
 
 void Graph::rename(GraphNode* target) {
 	//std::cout << "Renaming" << std::endl;
-	std::vector<GraphNode*> tempNodes = target->adjNodes;
+	const ArenaVector<GraphNode*>& tempNodes = target->adjNodes;
 
-	if(target->compromised || target->affected) 
-		target->currentName = target->originalName;
+	if(downNodes.test(target->index)) 
+		names[target->index] = target->index;
 	
 	unsigned int adjNodesSize = tempNodes.size();
 	for(unsigned int i = 0; i < adjNodesSize;i++) {
 		GraphNode* tempNode = tempNodes[i];
+		int& currentName = names[tempNode->index];
 
 		//find uncompromised and unaffected node through name path stack
-		while((tempNode->currentName != tempNode->originalName) && (nodes[tempNode->currentName].compromised || nodes[tempNode->currentName].affected)) {
+		while((currentName != tempNode->index) && downNodes.test(currentName)) {
 			int index = tempNode->namePathStack.top();
 			if(tempNode->namePathStack.size() == 1) {
-				tempNode->currentName = tempNode->namePathStack.top();
+				currentName = tempNode->namePathStack.top();
 				//std::cout << "NamePathStack(0) is " << tempNode->namePathStack.top() << std::endl;
 				//std::cout << "Original Name is " << tempNode->originalName << std::endl;
-			} else if(nodes[index].compromised||nodes[index].affected) {
+			} else if(downNodes.test(index)) {
 				tempNode->namePathStack.pop();
 			} else {
-				tempNode->currentName = tempNode->namePathStack.top();
+				currentName = tempNode->namePathStack.top();
 			}
 		}
 	}
@@ -341,23 +718,28 @@ void Graph::rename(GraphNode* target) {
 
 //If spanning tree have a different value, it is a partitioned tree.
 bool Graph::partitioned() {
-	int tempIndex1 = -1;
+	STATS_TIME_OP(OP_PARTITIONED);
+	//the second node of the first tree entry in row major order of
+	//originalName is the one every other node is compared against
 	int tempIndex2 = -1;
-	
+	for(int i = 0; i < numNodes && tempIndex2 == -1; i++) {
+		const int* row = spanningTree[slots[i]];
+		for(int j = 0; j < numNodes; j++)
+			if(row[j] > 0 && (tempIndex2 == -1 || nodes[j].originalName < nodes[tempIndex2].originalName))
+				tempIndex2 = j;
+	}
+	if(tempIndex2 == -1) {
+		std::cout << "The tree is complete." << std::endl;
+		return false;
+	}
+
+	//every node with a tree entry in its row must share that name
+	int tempName2 = names[tempIndex2];
 	for(int i = 0; i < numNodes; i++) {
+		const int* row = spanningTree[i];
 		for(int j = 0; j < numNodes; j++) {
-			int tempCost = spanningTree[i][j];
-			if(tempCost > 0) {
-				//initialize at first time
-				if(tempIndex1 == -1) {
-					tempIndex1 = i;
-					tempIndex2 = j;
-				}
-
-				tempIndex1 = i;
-				
-				int tempName1 = nodes[tempIndex1].currentName;
-				int tempName2 = nodes[tempIndex2].currentName;
+			if(row[j] > 0) {
+				int tempName1 = names[i];
 				//std::cout << "Current name1 is " << tempName1 << std::endl;
 				//std::cout << "Current name2 is " << tempName2 << std::endl;
 
@@ -365,12 +747,59 @@ bool Graph::partitioned() {
 					std::cout << "The tree is partitioned." << std::endl;
 					return true;
 				}
+				break;
 			}
-
 		}
 	}
 
 	std::cout << "The tree is complete." << std::endl;
 	return false;
 }
+
+long long Graph::spanningTreeCost() const {
+	long long total = 0;
+	for(int i = 0; i < numNodes; i++)
+		for(int j = 0; j < numNodes; j++)
+			total += spanningTree[i][j];
+	return total;
+}
+
+long long Graph::optimalCost() const {
+	return this->fakeCost;
+}
+
+//number of distinct union find names among surviving nodes, marked off
+//in a buffer the graph keeps
+int Graph::componentCount() {
+	std::fill(seenNames.begin(), seenNames.end(), 0);
+	int components = 0;
+	for(int i = 0; i < numNodes; i++) {
+		if(downNodes.test(i))
+			continue;
+		if(!seenNames[names[i]]) {
+			seenNames[names[i]] = 1;
+			components++;
+		}
+	}
+	return components;
+}
+
+//every (i, j) with j < i and an edge i -> j, by originalName, row by row
+void Graph::lowerEdges(std::vector<std::pair<int, int> >& edges) const {
+	for(int i = 0; i < numNodes; i++)
+		for(int j = 0; j < i; j++)
+			if(getCost(i, j) != 0)
+				edges.push_back(std::make_pair(i, j));
+}
+
+//filled into a buffer the graph keeps, valid until the next call
+const std::vector<int>& Graph::missingNodes() {
+	std::vector<int>& missing = this->missing;
+	missing.clear();
+	downNodes.list(missing);
+	for(unsigned int i = 0; i < missing.size(); i++)
+		missing[i] = nodes[missing[i]].originalName;
+	std::sort(missing.begin(), missing.end());
+	return missing;
+}
 #endif 
@@ -2,6 +2,7 @@
 
 #ifndef HEAP_H
 #define HEAP_H
+#include <algorithm>
 
 /*
  * Container for the heap. Has a field for the content and a tag to support 
@@ -83,11 +84,13 @@ class Heap {
     Heap<NodeContents> operator=(Heap<NodeContents>& h);
     ~Heap();
 
+    void reserve(int capacity);
     void push(PriorityContainer<NodeContents> x);
     void push(NodeContents x, int priority) {
       this->push(PriorityContainer<NodeContents>(x, priority));
     }
     PriorityContainer<NodeContents> pop();
+    PriorityContainer<NodeContents> peek() {  return this->grab(0);  }
 
     // Since I make no assumptions about the comparison function 
     // except that it gives a legitimate location in the heap for
@@ -106,6 +109,7 @@ class Heap {
     }
 
     bool isEmpty() {  return this->occupied == 0;  }
+    int count() {  return this->occupied;  }
 };
 
 // Create an alias for the type of Tiebreaker function pointers
@@ -194,22 +198,27 @@ Heap<NodeContents>::~Heap() {
  */
 template<typename NodeContents>
 void Heap<NodeContents>::push(PriorityContainer<NodeContents> x) {
-  if (this->occupied >= this->size) {
-    int newSize = this->occupied * 2;
-    PriorityContainer<NodeContents> *newContents = new PriorityContainer<NodeContents>[newSize];
-    for (int i = 0; i < this->occupied; i++) {
-      newContents[i] = this->contents[i];
-    }
-    delete[] this->contents;
-    this->contents = newContents;
-    this->size = newSize;
-  }
+  if (this->occupied >= this->size)
+    this->reserve(this->occupied * 2);
 
   this->place(x, this->getOpenIndex());
   this->occupied++;
   this->percolateUp(this->getLastIndex());
 }
 
+// Grows the array to hold at least capacity nodes, moving the occupied
+// cells over in one pass. Never shrinks
+template<typename NodeContents>
+void Heap<NodeContents>::reserve(int capacity) {
+  if (capacity <= this->size)
+    return;
+  PriorityContainer<NodeContents> *newContents = new PriorityContainer<NodeContents>[capacity];
+  std::move(this->contents, this->contents + this->occupied, newContents);
+  delete[] this->contents;
+  this->contents = newContents;
+  this->size = capacity;
+}
+
 /* pop:
  * Gets the node to return, and then addresses the edge case of us having removed
  * the last node in the heap. Grabs the bottom-most element in the heap, places it
@@ -237,6 +246,10 @@ template<typename NodeContents>
 void Heap<NodeContents>::percolateDown(int index) {
   int leftChildIndex = this->getLeftChildIndex(index);
   int rightChildIndex = this->getRightChildIndex(index);
+  // a leaf ends the percolation without going through NO_CHILD, every
+  // thrown exception is a heap allocation
+  if (!this->hasNode(leftChildIndex))
+    return;
 
   try {
     int compareAgainst = this->returnTopper(leftChildIndex, rightChildIndex);
@@ -0,0 +1,330 @@
+//columnar rebuild metrics
+//every rebuild appends its time, tree cost, optimal cost and component count
+//to fixed width columns, and its missing nodes as the nodes that went down or
+//came back since the previous rebuild. Columns are written a block of
+//rebuilds at a time, so a reader scans a cost over a long run without
+//parsing text or decoding a single missing set
+
+#ifndef METRICS_H
+#define METRICS_H
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+/*
+ * Host byte order. The file is "DESM", int32 version, int32 numNodes, then
+ * blocks of up to blockRows rebuilds (at most DEFAULT_BLOCK_ROWS), each:
+ *
+ *   int32 rows, int32 changeBytes
+ *   int32 time[rows], int64 treeCost[rows], int64 optimalCost[rows],
+ *   int32 components[rows], int32 numMissing[rows], int32 numChanges[rows]
+ *   changeBytes bytes of missing set changes
+ *
+ * A row's changes are the numChanges nodes whose missing bit differs from
+ * the previous row of the block (the first row of a block is against no
+ * missing nodes, so every block decodes on its own), ascending, each as an
+ * LEB128 varint of its gap from the previous change: the xor of the two
+ * bitmaps, run length encoded.
+ */
+struct MetricsBlock {
+	std::vector<int32_t> time;
+	std::vector<int64_t> treeCost;
+	std::vector<int64_t> optimalCost;
+	std::vector<int32_t> components;
+	std::vector<int32_t> numMissing;
+	std::vector<int32_t> numChanges;
+	std::vector<unsigned char> changes;
+
+	int rows() const {  return this->time.size();  }
+	void reserve(int rows);
+	void clear();
+};
+
+void MetricsBlock::reserve(int rows) {
+	time.reserve(rows);
+	treeCost.reserve(rows);
+	optimalCost.reserve(rows);
+	components.reserve(rows);
+	numMissing.reserve(rows);
+	numChanges.reserve(rows);
+}
+
+void MetricsBlock::clear() {
+	time.clear();
+	treeCost.clear();
+	optimalCost.clear();
+	components.clear();
+	numMissing.clear();
+	numChanges.clear();
+	changes.clear();
+}
+
+/*
+ * Appends rebuilds to a metrics file, a block in memory at a time. The
+ * missing nodes passed to append() must be sorted, as every Network's
+ * missingNodes() is. The change bytes of a block have a fixed budget, a
+ * block that could not take another row's worth is written early, so the
+ * writer never grows after construction.
+ */
+class MetricsWriter {
+	private:
+		std::FILE* out;
+		int numNodes;
+		int blockRows;
+		MetricsBlock block;
+		std::vector<int> previous;    //missing nodes of the block's last row
+		long long numRows;
+		std::size_t maxRowBytes;      //changes of one row at most
+		std::size_t changeBudget;
+
+		void putChange(int gap);
+		void writeBlock();
+
+	public:
+		static const int DEFAULT_BLOCK_ROWS = 4096;
+		static const int CHANGE_BYTES_PER_ROW = 16;
+
+		MetricsWriter(const char* path, int numNodes, int blockRows = DEFAULT_BLOCK_ROWS);
+		~MetricsWriter() {  close();  }
+		MetricsWriter(const MetricsWriter&) = delete;
+		MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+		bool isOpen() const { return this->out != nullptr; }
+		long long getNumRows() const { return this->numRows; }
+
+		void append(int time, long long treeCost, long long optimalCost, int components, const std::vector<int>& missing);
+
+		//writes the last block, further appends are dropped
+		void close();
+};
+
+MetricsWriter::MetricsWriter(const char* path, int numNodes, int blockRows) : out(std::fopen(path, "wb")),
+	numNodes(numNodes), blockRows(blockRows > 0 && blockRows < DEFAULT_BLOCK_ROWS ? blockRows : DEFAULT_BLOCK_ROWS), numRows(0) {
+	//every node changes at most once a row and the gaps add up to less
+	//than numNodes, so only one gap in 128 can take more than a byte
+	maxRowBytes = numNodes + numNodes / 32 + 1;
+	changeBudget = (std::size_t)this->blockRows * CHANGE_BYTES_PER_ROW + maxRowBytes;
+	block.reserve(this->blockRows);
+	block.changes.reserve(changeBudget);
+	previous.reserve(numNodes);
+	if(!out)
+		return;
+	int32_t header[2] = {1, numNodes};
+	std::fwrite("DESM", 1, 4, out);
+	std::fwrite(header, sizeof(int32_t), 2, out);
+}
+
+void MetricsWriter::putChange(int gap) {
+	unsigned int value = gap;
+	while(value >= 0x80) {
+		block.changes.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	block.changes.push_back((unsigned char)value);
+}
+
+//both sets are sorted, so their difference comes out of one merge
+void MetricsWriter::append(int time, long long treeCost, long long optimalCost, int components, const std::vector<int>& missing) {
+	if(!out)
+		return;
+	if(block.changes.size() + maxRowBytes > changeBudget)
+		writeBlock();
+	int changed = 0;
+	int last = -1;
+	unsigned int i = 0, j = 0;
+	while(i < previous.size() || j < missing.size()) {
+		int node;
+		if(j == missing.size() || (i < previous.size() && previous[i] < missing[j])) {
+			node = previous[i++];
+		} else if(i == previous.size() || missing[j] < previous[i]) {
+			node = missing[j++];
+		} else {
+			i++;
+			j++;
+			continue;
+		}
+		putChange(node - last - 1);
+		last = node;
+		changed++;
+	}
+	previous.assign(missing.begin(), missing.end());
+
+	block.time.push_back(time);
+	block.treeCost.push_back(treeCost);
+	block.optimalCost.push_back(optimalCost);
+	block.components.push_back(components);
+	block.numMissing.push_back(missing.size());
+	block.numChanges.push_back(changed);
+	numRows++;
+	if(block.rows() == blockRows)
+		writeBlock();
+}
+
+void MetricsWriter::writeBlock() {
+	int rows = block.rows();
+	if(rows == 0)
+		return;
+	int32_t header[2] = {rows, (int32_t)block.changes.size()};
+	std::fwrite(header, sizeof(int32_t), 2, out);
+	std::fwrite(block.time.data(), sizeof(int32_t), rows, out);
+	std::fwrite(block.treeCost.data(), sizeof(int64_t), rows, out);
+	std::fwrite(block.optimalCost.data(), sizeof(int64_t), rows, out);
+	std::fwrite(block.components.data(), sizeof(int32_t), rows, out);
+	std::fwrite(block.numMissing.data(), sizeof(int32_t), rows, out);
+	std::fwrite(block.numChanges.data(), sizeof(int32_t), rows, out);
+	std::fwrite(block.changes.data(), 1, block.changes.size(), out);
+	block.clear();
+	previous.clear();
+}
+
+void MetricsWriter::close() {
+	if(!out)
+		return;
+	writeBlock();
+	std::fclose(out);
+	out = nullptr;
+}
+
+//one rebuild as read back, missing sorted
+struct MetricsRow {
+	int time;
+	long long treeCost;
+	long long optimalCost;
+	int components;
+	std::vector<int> missing;
+};
+
+/*
+ * Reads a metrics file a block at a time. getBlock() hands out the columns
+ * of the block readBlock() loaded as they are on disk; next() walks the
+ * rebuilds in order, reading blocks as it goes, and only it decodes the
+ * missing sets. A truncated or foreign file reads as ending early: a block
+ * header is checked against the writer's limits and the bytes left in the
+ * file before anything is sized from it, and a row never decodes more than
+ * numNodes changes or a node past numNodes.
+ */
+class MetricsReader {
+	private:
+		std::FILE* in;
+		long fileSize;
+		int numNodes;
+		MetricsBlock block;
+		int row;                    //next row of block for next()
+		std::size_t changeOffset;
+		std::vector<int> missing;
+		std::vector<int> merged;
+
+		template<typename T>
+		bool readColumn(std::vector<T>& column, int rows) {
+			column.resize(rows);
+			return std::fread(column.data(), sizeof(T), rows, in) == (std::size_t)rows;
+		}
+		unsigned int getChange();
+
+	public:
+		MetricsReader(const char* path);
+		~MetricsReader() {
+			if(in)
+				std::fclose(in);
+		}
+		MetricsReader(const MetricsReader&) = delete;
+		MetricsReader& operator=(const MetricsReader&) = delete;
+
+		bool isOpen() const { return this->in != nullptr; }
+		int getNumNodes() const { return this->numNodes; }
+
+		//false at the end of the file; next() carries on from this block's start
+		bool readBlock();
+		const MetricsBlock& getBlock() const { return this->block; }
+
+		bool next(MetricsRow& out);
+};
+
+MetricsReader::MetricsReader(const char* path) : in(std::fopen(path, "rb")), fileSize(0), numNodes(0), row(0), changeOffset(0) {
+	if(!in)
+		return;
+	char magic[4];
+	int32_t header[2];
+	if(std::fseek(in, 0, SEEK_END) == 0)
+		fileSize = std::ftell(in);
+	std::rewind(in);
+	if(std::fread(magic, 1, 4, in) != 4 || std::memcmp(magic, "DESM", 4) != 0
+		|| std::fread(header, sizeof(int32_t), 2, in) != 2 || header[0] != 1 || header[1] < 0) {
+		std::fclose(in);
+		in = nullptr;
+		return;
+	}
+	numNodes = header[1];
+	missing.reserve(numNodes);
+	merged.reserve(numNodes);
+}
+
+bool MetricsReader::readBlock() {
+	block.clear();
+	row = 0;
+	changeOffset = 0;
+	missing.clear();
+	int32_t header[2];
+	if(!in || std::fread(header, sizeof(int32_t), 2, in) != 2)
+		return false;
+	int rows = header[0];
+	long columnBytes = (long)rows * (4 * sizeof(int32_t) + 2 * sizeof(int64_t));
+	if(rows <= 0 || rows > MetricsWriter::DEFAULT_BLOCK_ROWS || header[1] < 0
+		|| columnBytes + header[1] > fileSize - std::ftell(in))
+		return false;
+	bool read = readColumn(block.time, rows) && readColumn(block.treeCost, rows)
+		&& readColumn(block.optimalCost, rows) && readColumn(block.components, rows)
+		&& readColumn(block.numMissing, rows) && readColumn(block.numChanges, rows)
+		&& readColumn(block.changes, header[1]);
+	if(!read)
+		block.clear();
+	return read;
+}
+
+//an int takes at most 5 bytes, a longer run ends the varint there
+unsigned int MetricsReader::getChange() {
+	unsigned int value = 0;
+	for(int shift = 0; shift < 35 && changeOffset < block.changes.size(); shift += 7) {
+		unsigned char byte = block.changes[changeOffset++];
+		value |= (unsigned int)(byte & 0x7f) << shift;
+		if(!(byte & 0x80))
+			break;
+	}
+	return value;
+}
+
+bool MetricsReader::next(MetricsRow& out) {
+	if(row == block.rows() && !readBlock())
+		return false;
+
+	//the row's changes flip nodes in or out of the sorted missing set
+	merged.clear();
+	unsigned int i = 0;
+	int node = -1;
+	int numChanges = std::min(block.numChanges[row], numNodes);
+	for(int k = 0; k < numChanges; k++) {
+		unsigned int gap = getChange();
+		if(gap >= (unsigned int)(numNodes - node - 1))
+			break;
+		node += gap + 1;
+		while(i < missing.size() && missing[i] < node)
+			merged.push_back(missing[i++]);
+		if(i < missing.size() && missing[i] == node)
+			i++;
+		else
+			merged.push_back(node);
+	}
+	merged.insert(merged.end(), missing.begin() + i, missing.end());
+	missing.swap(merged);
+
+	out.time = block.time[row];
+	out.treeCost = block.treeCost[row];
+	out.optimalCost = block.optimalCost[row];
+	out.components = block.components[row];
+	out.missing.assign(missing.begin(), missing.end());
+	row++;
+	return true;
+}
+#endif
@@ -0,0 +1,190 @@
+//cache of optimal forests for the graph
+//the optimal forest only depends on which nodes are down, and the down set
+//keeps coming back to states it has been in before as sysadmins fix nodes,
+//so rebuilds look the forest up by a Zobrist hash of the down set first
+
+#ifndef MSTCACHE_H
+#define MSTCACHE_H
+#include "nodeset.hpp"
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+//random 64 bit key of a node (splitmix64 of its index), the hash of a set
+//is the xor of its members' keys so adding or removing one is a single xor
+inline uint64_t zobristKey(int node) {
+	uint64_t z = (uint64_t)node + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+//optimal forest for one down set, edges are positions in the sorted edge list
+struct CachedForest {
+	uint64_t hash;
+	std::vector<uint64_t> down;
+	long long cost;
+	std::vector<int> edges;
+};
+
+/*
+ * Least recently used cache of optimal forests keyed by the down set's hash.
+ * A hit also compares the stored down set word by word, so a hash collision
+ * is a miss rather than a wrong forest. Capacity 0 turns the cache off.
+ *
+ * Entries sit in a fixed array linked newest to oldest and are found through
+ * an open addressed table of entry numbers. Every entry's vectors are sized
+ * for the whole network up front and eviction reuses the oldest entry, so
+ * lookups and inserts never allocate.
+ */
+class ForestCache {
+	private:
+		int capacity;
+		int numNodes;
+		int used;
+		std::vector<CachedForest> entries;
+		std::vector<int> newer;    //recency links, -1 past either end
+		std::vector<int> older;
+		int newest;
+		int oldest;
+		std::vector<int> table;    //entry number or -1, linear probing
+		long long lookups;
+		long long hits;
+
+		static int numWords(const NodeSet& down) {  return (down.size() + 63) / 64;  }
+		int home(uint64_t hash) const {  return (int)(hash & (table.size() - 1));  }
+		int position(uint64_t hash) const;
+		void unlink(int entry);
+		void pushNewest(int entry);
+		void erase(int hole);
+	public:
+		ForestCache(int capacity = 0, int numNodes = 0) : capacity(0), numNodes(numNodes), used(0),
+			newest(-1), oldest(-1), lookups(0), hits(0) {
+			setCapacity(capacity);
+		}
+
+		//both empty the cache
+		void setCapacity(int capacity);
+		void clear();
+		int getCapacity() const { return this->capacity; }
+		int size() const { return this->used; }
+		long long getLookups() const { return this->lookups; }
+		long long getHits() const { return this->hits; }
+
+		//null on a miss
+		const CachedForest* find(uint64_t hash, const NodeSet& down);
+		void insert(uint64_t hash, const NodeSet& down, long long cost, const std::vector<int>& edges);
+};
+
+void ForestCache::setCapacity(int capacity) {
+	this->capacity = capacity > 0 ? capacity : 0;
+	entries.assign(this->capacity, CachedForest());
+	for(int i = 0; i < this->capacity; i++) {
+		entries[i].down.reserve((numNodes + 63) / 64);
+		entries[i].edges.reserve(numNodes);
+	}
+	newer.assign(this->capacity, -1);
+	older.assign(this->capacity, -1);
+	int tableSize = 1;
+	while(tableSize < 2 * this->capacity)
+		tableSize *= 2;
+	table.assign(tableSize, -1);
+	used = 0;
+	newest = oldest = -1;
+}
+
+void ForestCache::clear() {
+	table.assign(table.size(), -1);
+	used = 0;
+	newest = oldest = -1;
+}
+
+//table position holding hash, or the empty one it would go in
+int ForestCache::position(uint64_t hash) const {
+	int mask = table.size() - 1;
+	int i = home(hash);
+	while(table[i] != -1 && entries[table[i]].hash != hash)
+		i = (i + 1) & mask;
+	return i;
+}
+
+void ForestCache::unlink(int entry) {
+	if(newer[entry] != -1)
+		older[newer[entry]] = older[entry];
+	else
+		newest = older[entry];
+	if(older[entry] != -1)
+		newer[older[entry]] = newer[entry];
+	else
+		oldest = newer[entry];
+}
+
+void ForestCache::pushNewest(int entry) {
+	newer[entry] = -1;
+	older[entry] = newest;
+	if(newest != -1)
+		newer[newest] = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+//empties a table position and moves later entries of the same run back
+//into the hole when their home allows it, so probing never stops early
+void ForestCache::erase(int hole) {
+	int mask = table.size() - 1;
+	table[hole] = -1;
+	for(int i = (hole + 1) & mask; table[i] != -1; i = (i + 1) & mask) {
+		int want = home(entries[table[i]].hash);
+		if(((i - want) & mask) >= ((i - hole) & mask)) {
+			table[hole] = table[i];
+			table[i] = -1;
+			hole = i;
+		}
+	}
+}
+
+const CachedForest* ForestCache::find(uint64_t hash, const NodeSet& down) {
+	if(capacity == 0)
+		return nullptr;
+	lookups++;
+	int entry = table[position(hash)];
+	if(entry == -1)
+		return nullptr;
+	if(std::memcmp(entries[entry].down.data(), down.data(), numWords(down) * sizeof(uint64_t)) != 0)
+		return nullptr;
+	unlink(entry);
+	pushNewest(entry);
+	hits++;
+	return &entries[entry];
+}
+
+//a hash already cached is overwritten, otherwise the oldest entry is
+//reused once every entry is taken
+void ForestCache::insert(uint64_t hash, const NodeSet& down, long long cost, const std::vector<int>& edges) {
+	if(capacity == 0)
+		return;
+	int i = position(hash);
+	int entry = table[i];
+	if(entry != -1) {
+		unlink(entry);
+	} else {
+		if(used < capacity) {
+			entry = used++;
+		} else {
+			entry = oldest;
+			unlink(entry);
+			erase(position(entries[entry].hash));
+			i = position(hash);
+		}
+		table[i] = entry;
+	}
+
+	CachedForest& forest = entries[entry];
+	forest.hash = hash;
+	forest.down.assign(down.data(), down.data() + numWords(down));
+	forest.cost = cost;
+	forest.edges.assign(edges.begin(), edges.end());
+	pushNewest(entry);
+}
+#endif
@@ -0,0 +1,178 @@
+//dense per-node state for the graph
+//a NodeSet is one bit per node, packed 64 to a word, a NodeSampler keeps a
+//set of nodes that can be picked from at random, plus the scan kernels
+//the graph runs over node state. Every kernel has an AVX2 version, used
+//when compiled with -mavx2 (or -march=native), and a scalar one
+
+#ifndef NODESET_H
+#define NODESET_H
+#include <stdint.h>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+class NodeSet {
+	private:
+		int numNodes;
+		std::vector<uint64_t> words;
+	public:
+		NodeSet(int numNodes) : numNodes(numNodes), words((numNodes + 63) / 64 + 1, 0) { }
+
+		bool test(int node) const {  return (words[node >> 6] >> (node & 63)) & 1;  }
+		void set(int node) {  words[node >> 6] |= (uint64_t)1 << (node & 63);  }
+		void reset(int node) {  words[node >> 6] &= ~((uint64_t)1 << (node & 63));  }
+		int size() const {  return this->numNodes;  }
+		const uint64_t* data() const {  return this->words.data();  }
+
+		int count() const;
+		void list(std::vector<int>& out) const;
+		void listClear(std::vector<int>& out) const;
+};
+
+int NodeSet::count() const {
+	int numWords = (numNodes + 63) / 64;
+	int total = 0;
+	int i = 0;
+#ifdef __AVX2__
+	//nibble lookup popcount, 256 bits at a time
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	__m256i sums = _mm256_setzero_si256();
+	for(; i + 4 <= numWords; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(words.data() + i));
+		__m256i counts = _mm256_add_epi8(
+			_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+			_mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+		sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+	}
+	uint64_t lanes[4];
+	_mm256_storeu_si256((__m256i*)lanes, sums);
+	total = (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#endif
+	for(; i < numWords; i++)
+		total += __builtin_popcountll(words[i]);
+	return total;
+}
+
+//appends every node in the set
+void NodeSet::list(std::vector<int>& out) const {
+	int numWords = (numNodes + 63) / 64;
+	for(int i = 0; i < numWords; i++) {
+		uint64_t word = words[i];
+		while(word) {
+			out.push_back(i * 64 + __builtin_ctzll(word));
+			word &= word - 1;
+		}
+	}
+}
+
+//appends every node not in the set
+void NodeSet::listClear(std::vector<int>& out) const {
+	int numWords = (numNodes + 63) / 64;
+	for(int i = 0; i < numWords; i++) {
+		uint64_t word = ~words[i];
+		if(i == numWords - 1 && (numNodes & 63))
+			word &= ((uint64_t)1 << (numNodes & 63)) - 1;
+		while(word) {
+			out.push_back(i * 64 + __builtin_ctzll(word));
+			word &= word - 1;
+		}
+	}
+}
+
+/*
+ * The members of a set of nodes packed at the front of an array, with every
+ * node's position in it, so insert, erase and picking the i-th member are
+ * all O(1). Erasing moves the last member into the hole.
+ */
+class NodeSampler {
+	private:
+		std::vector<int> members;
+		std::vector<int> position;   //-1 when not a member
+	public:
+		NodeSampler() { }
+		NodeSampler(int numNodes) : position(numNodes, -1) {  members.reserve(numNodes);  }
+
+		bool contains(int node) const {  return this->position[node] != -1;  }
+		int size() const {  return this->members.size();  }
+		int at(int index) const {  return this->members[index];  }
+
+		void insert(int node) {
+			if(position[node] != -1)
+				return;
+			position[node] = members.size();
+			members.push_back(node);
+		}
+
+		void erase(int node) {
+			int index = position[node];
+			if(index == -1)
+				return;
+			int last = members.back();
+			members[index] = last;
+			position[last] = index;
+			members.pop_back();
+			position[node] = -1;
+		}
+};
+
+/*
+ * Writes the index of every edge whose endpoints are both outside down to
+ * out and returns how many there are. left and right hold the endpoints of
+ * edge k at index k. The AVX2 version tests 8 edges at a time by gathering
+ * the 32 bit words holding each endpoint's bit.
+ */
+inline int selectLiveEdges(const NodeSet& down, const int* left, const int* right, int count, int* out) {
+	int kept = 0;
+	int k = 0;
+#ifdef __AVX2__
+	const int* bits = (const int*)down.data();
+	const __m256i five = _mm256_set1_epi32(5);
+	const __m256i thirtyOne = _mm256_set1_epi32(31);
+	const __m256i one = _mm256_set1_epi32(1);
+	for(; k + 8 <= count; k += 8) {
+		__m256i l = _mm256_loadu_si256((const __m256i*)(left + k));
+		__m256i r = _mm256_loadu_si256((const __m256i*)(right + k));
+		__m256i lWords = _mm256_i32gather_epi32(bits, _mm256_srlv_epi32(l, five), 4);
+		__m256i rWords = _mm256_i32gather_epi32(bits, _mm256_srlv_epi32(r, five), 4);
+		__m256i lBits = _mm256_srlv_epi32(lWords, _mm256_and_si256(l, thirtyOne));
+		__m256i rBits = _mm256_srlv_epi32(rWords, _mm256_and_si256(r, thirtyOne));
+		__m256i dead = _mm256_and_si256(_mm256_or_si256(lBits, rBits), one);
+		int liveMask = _mm256_movemask_ps(_mm256_castsi256_ps(
+			_mm256_cmpeq_epi32(dead, _mm256_setzero_si256())));
+		while(liveMask) {
+			out[kept++] = k + __builtin_ctz(liveMask);
+			liveMask &= liveMask - 1;
+		}
+	}
+#endif
+	for(; k < count; k++)
+		if(!down.test(left[k]) && !down.test(right[k]))
+			out[kept++] = k;
+	return kept;
+}
+
+//Writes the index of every entry of values equal to value to out and
+//returns how many there are
+inline int findEqual(const int* values, int count, int value, int* out) {
+	int found = 0;
+	int i = 0;
+#ifdef __AVX2__
+	const __m256i target = _mm256_set1_epi32(value);
+	for(; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, target)));
+		while(mask) {
+			out[found++] = i + __builtin_ctz(mask);
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for(; i < count; i++)
+		if(values[i] == value)
+			out[found++] = i;
+	return found;
+}
+#endif
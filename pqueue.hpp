@@ -12,10 +12,14 @@ class PriorityQueue {
     PriorityQueue() : heap() { }
     PriorityQueue(int size) : heap(size) { }
 
+    void reserve(int size) {  this->heap.reserve(size);  }
     void push(Contents& c, long long priority) {  this->heap.push(c, priority);  }
     Contents popContent() {  return this->heap.pop().content;  }
     PriorityContainer<Contents> pop() {  return this->heap.pop();  }
+    long long peekPriority() {  return this->heap.peek().priority;  }
+    Contents peekContent() {  return this->heap.peek().content;  }
     bool isEmpty() {  return this->heap.isEmpty();  
 	}
+    int size() {  return this->heap.count();  }
 };
 #endif
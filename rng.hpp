@@ -0,0 +1,131 @@
+//random number policies for the simulator
+//every draw names the stream (agent) it belongs to. MersenneRNG keeps the
+//original single std::mt19937 shared by all agents, XoshiroRNG gives every
+//agent its own multi-lane xoshiro256** stream refilled a block at a time
+
+#ifndef RNG_H
+#define RNG_H
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+//The original generator, streams are ignored
+class MersenneRNG {
+	private:
+		std::mt19937 mt;
+	public:
+		MersenneRNG(int seed, int) : mt(seed) { }
+
+		int uniform(int, int low, int high) {
+			return std::uniform_int_distribution<int>(low, high)(this->mt);
+		}
+};
+
+//used to expand one seed into many independent lane states
+inline uint64_t splitMix64(uint64_t& state) {
+	uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*
+ * Lanes independent xoshiro256** generators stored lane-major (s0 of every
+ * lane, then s1 of every lane, ...) so the update of all lanes is a straight
+ * line loop the compiler turns into vector instructions (4 lanes fill one
+ * AVX2 register). refill() produces Rounds outputs per lane at a time, round
+ * by round, so the sequence a stream sees does not depend on Rounds.
+ */
+template<int Lanes, int Rounds>
+class XoshiroStream {
+	private:
+		uint64_t s0[Lanes], s1[Lanes], s2[Lanes], s3[Lanes];
+		uint32_t block[Lanes * Rounds];
+		int next;
+
+		static uint64_t rotl(uint64_t x, int k) {  return (x << k) | (x >> (64 - k));  }
+
+		void refill() {
+			for(int r = 0; r < Rounds; r++) {
+				uint32_t* out = block + r * Lanes;
+				for(int l = 0; l < Lanes; l++) {
+					uint64_t result = rotl(s1[l] * 5, 7) * 9;
+					uint64_t t = s1[l] << 17;
+					s2[l] ^= s0[l];
+					s3[l] ^= s1[l];
+					s1[l] ^= s2[l];
+					s0[l] ^= s3[l];
+					s2[l] ^= t;
+					s3[l] = rotl(s3[l], 45);
+					//the high bits are the strongest
+					out[l] = (uint32_t)(result >> 32);
+				}
+			}
+			next = 0;
+		}
+
+	public:
+		XoshiroStream() : next(Lanes * Rounds) {
+			for(int l = 0; l < Lanes; l++)
+				s0[l] = s1[l] = s2[l] = s3[l] = 0;
+		}
+
+		void seed(uint64_t seed, uint64_t stream) {
+			uint64_t state = seed ^ (stream * 0xd1b54a32d192ed03ULL);
+			for(int l = 0; l < Lanes; l++) {
+				s0[l] = splitMix64(state);
+				s1[l] = splitMix64(state);
+				s2[l] = splitMix64(state);
+				s3[l] = splitMix64(state);
+			}
+			next = Lanes * Rounds;
+		}
+
+		uint32_t next32() {
+			if(next == Lanes * Rounds)
+				refill();
+			return block[next++];
+		}
+
+		//Lemire's nearly divisionless reduction to [0, range)
+		uint32_t bounded(uint32_t range) {
+			uint64_t m = (uint64_t)next32() * range;
+			uint32_t low = (uint32_t)m;
+			if(low < range) {
+				uint32_t threshold = (0u - range) % range;
+				while(low < threshold) {
+					m = (uint64_t)next32() * range;
+					low = (uint32_t)m;
+				}
+			}
+			return (uint32_t)(m >> 32);
+		}
+};
+
+//One XoshiroStream per agent, created on first use
+template<int Lanes = 4, int Rounds = 16>
+class XoshiroRNG {
+	private:
+		uint64_t seed;
+		std::vector<XoshiroStream<Lanes, Rounds> > streams;
+
+		XoshiroStream<Lanes, Rounds>& stream(int id) {
+			if(id >= (int)streams.size()) {
+				int oldSize = streams.size();
+				streams.resize(id + 1);
+				for(int i = oldSize; i <= id; i++)
+					streams[i].seed(this->seed, i);
+			}
+			return streams[id];
+		}
+
+	public:
+		XoshiroRNG(int seed, int numStreams) : seed(seed) {
+			this->stream(numStreams > 0 ? numStreams - 1 : 0);
+		}
+
+		int uniform(int stream, int low, int high) {
+			return low + (int)this->stream(stream).bounded((uint32_t)(high - low) + 1);
+		}
+};
+#endif
@@ -0,0 +1,200 @@
+//routing table queries over the spanning forest
+//answers path cost, hop count and bottleneck (most expensive edge) between
+//two nodes in O(log n) with binary lifting
+
+#ifndef ROUTING_H
+#define ROUTING_H
+#include <vector>
+
+struct Route {
+	bool connected;
+	long long cost;
+	int hops;
+	int bottleneck;
+};
+
+/*
+ * Built from the tree links with reset(), addLink() for every link and
+ * finish(). finish() lays the forest out in breadth first order, so every
+ * parent comes before its children and the jump tables fill in one pass,
+ * and stores each node's ancestor and max edge for a jump of 2^k next to
+ * each other so one climb step touches a single cache line. Buffers are
+ * kept between refreshes, but every refresh lays out the whole forest
+ * again: there is no update of just the subtree that changed.
+ */
+class RoutingTable {
+	private:
+		struct Jump {
+			int ancestor;   //bfs position of the 2^k-th ancestor
+			int maxEdge;    //most expensive edge on the way there
+		};
+
+		int numNodes;
+		int levels;
+
+		//links as an adjacency array
+		std::vector<int> linkLeft, linkRight, linkCost;
+		std::vector<int> offsets, targets, costs;
+
+		//per bfs position
+		std::vector<int> position;  //node -> bfs position
+		std::vector<int> component;
+		std::vector<int> depth;
+		std::vector<long long> distance;  //cost from the root of the tree
+		std::vector<Jump> jumps;          //levels entries per position
+
+		Jump& jump(int index, int k) {  return jumps[index * levels + k];  }
+		const Jump& jump(int index, int k) const {  return jumps[index * levels + k];  }
+
+	public:
+		RoutingTable() : numNodes(0), levels(1) { }
+
+		void reset(int numNodes) {
+			this->numNodes = numNodes;
+			linkLeft.clear();
+			linkRight.clear();
+			linkCost.clear();
+		}
+
+		void addLink(int left, int right, int cost) {
+			linkLeft.push_back(left);
+			linkRight.push_back(right);
+			linkCost.push_back(cost);
+		}
+
+		void finish();
+		Route route(int source, int target) const;
+		int getNumNodes() const { return this->numNodes; }
+};
+
+void RoutingTable::finish() {
+	levels = 1;
+	while((1 << levels) < numNodes)
+		levels++;
+
+	//adjacency array
+	offsets.assign(numNodes + 1, 0);
+	for(unsigned int i = 0; i < linkLeft.size(); i++) {
+		offsets[linkLeft[i] + 1]++;
+		offsets[linkRight[i] + 1]++;
+	}
+	for(int i = 0; i < numNodes; i++)
+		offsets[i + 1] += offsets[i];
+	targets.resize(offsets[numNodes]);
+	costs.resize(offsets[numNodes]);
+	std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+	for(unsigned int i = 0; i < linkLeft.size(); i++) {
+		targets[fill[linkLeft[i]]] = linkRight[i];
+		costs[fill[linkLeft[i]]++] = linkCost[i];
+		targets[fill[linkRight[i]]] = linkLeft[i];
+		costs[fill[linkRight[i]]++] = linkCost[i];
+	}
+
+	//breadth first layout, tree by tree
+	position.assign(numNodes, -1);
+	component.resize(numNodes);
+	depth.resize(numNodes);
+	distance.resize(numNodes);
+	jumps.resize(numNodes * levels);
+	std::vector<int> order(numNodes);
+	int placed = 0;
+	for(int root = 0; root < numNodes; root++) {
+		if(position[root] != -1)
+			continue;
+		int head = placed;
+		position[root] = placed;
+		order[placed] = root;
+		component[placed] = root;
+		depth[placed] = 0;
+		distance[placed] = 0;
+		jump(placed, 0).ancestor = placed;
+		jump(placed, 0).maxEdge = 0;
+		placed++;
+
+		while(head < placed) {
+			int index = head++;
+			int node = order[index];
+			for(int i = offsets[node]; i < offsets[node + 1]; i++) {
+				int next = targets[i];
+				if(position[next] != -1)
+					continue;
+				position[next] = placed;
+				order[placed] = next;
+				component[placed] = root;
+				depth[placed] = depth[index] + 1;
+				distance[placed] = distance[index] + costs[i];
+				jump(placed, 0).ancestor = index;
+				jump(placed, 0).maxEdge = costs[i];
+				placed++;
+			}
+		}
+	}
+
+	//parents come first in bfs order, so their tables are already complete
+	for(int index = 0; index < numNodes; index++) {
+		for(int k = 1; k < levels; k++) {
+			const Jump& half = jump(index, k - 1);
+			const Jump& rest = jump(half.ancestor, k - 1);
+			jump(index, k).ancestor = rest.ancestor;
+			jump(index, k).maxEdge = (half.maxEdge > rest.maxEdge) ? half.maxEdge : rest.maxEdge;
+		}
+	}
+}
+
+Route RoutingTable::route(int source, int target) const {
+	Route result;
+	result.connected = false;
+	result.cost = 0;
+	result.hops = 0;
+	result.bottleneck = 0;
+
+	int u = position[source];
+	int v = position[target];
+	if(component[u] != component[v])
+		return result;
+
+	int maxEdge = 0;
+	if(depth[u] < depth[v]) {
+		int temp = u;
+		u = v;
+		v = temp;
+	}
+
+	//lift the deeper node to the same depth
+	int diff = depth[u] - depth[v];
+	for(int k = 0; diff > 0; k++, diff >>= 1) {
+		if(diff & 1) {
+			if(jump(u, k).maxEdge > maxEdge)
+				maxEdge = jump(u, k).maxEdge;
+			u = jump(u, k).ancestor;
+		}
+	}
+
+	//lift both to just below the lowest common ancestor
+	if(u != v) {
+		for(int k = levels - 1; k >= 0; k--) {
+			if(jump(u, k).ancestor != jump(v, k).ancestor) {
+				if(jump(u, k).maxEdge > maxEdge)
+					maxEdge = jump(u, k).maxEdge;
+				if(jump(v, k).maxEdge > maxEdge)
+					maxEdge = jump(v, k).maxEdge;
+				u = jump(u, k).ancestor;
+				v = jump(v, k).ancestor;
+			}
+		}
+		if(jump(u, 0).maxEdge > maxEdge)
+			maxEdge = jump(u, 0).maxEdge;
+		if(jump(v, 0).maxEdge > maxEdge)
+			maxEdge = jump(v, 0).maxEdge;
+		u = jump(u, 0).ancestor;
+	}
+
+	int s = position[source];
+	int t = position[target];
+	result.connected = true;
+	result.cost = distance[s] + distance[t] - 2 * distance[u];
+	result.hops = depth[s] + depth[t] - 2 * depth[u];
+	result.bottleneck = maxEdge;
+	return result;
+}
+#endif
@@ -0,0 +1,701 @@
+//graph sharded over worker processes
+//the n x n cost matrix is what caps the network size in one address space,
+//so a ShardedGraph forks workers that each generate and keep only a block of
+//its rows, and holds nothing bigger than per node state itself. Attacks,
+//fixes and partition checks never leave the coordinating process; a rebuild
+//hands the workers the live nodes and their union find names through shared
+//memory and merges their answers over rounds of distributed Boruvka, each
+//worker sending the cheapest edge its rows have out of every component
+//through a futex-backed queue. Ties are broken in Graph's edge order, so the
+//forest and every line the simulator prints are the ones Graph gives
+
+#ifndef SHARD_H
+#define SHARD_H
+#include "graph.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//an edge by its place in Graph's sorted edge list: cost first, then the
+//edge list's row major order. Cost 0 is no edge
+struct ShardEdge {
+	int cost;
+	int left;
+	int right;
+
+	bool operator<(const ShardEdge& other) const {
+		if(cost != other.cost)
+			return cost < other.cost;
+		return left < other.left || (left == other.left && right < other.right);
+	}
+};
+
+enum SHARD_COMMAND {
+	SHARD_ROUND = 0,    //one Boruvka round over the labels
+	SHARD_COST,         //the cost of left -> right, left in the worker's rows
+	SHARD_EDGES,        //the worker's edges i -> j with j < i from row left, column right on
+	SHARD_EXIT
+};
+
+struct ShardMessage {
+	int type;
+	int left;
+	int right;
+};
+
+/*
+ * Single producer single consumer queue that lives in memory shared between
+ * processes, so its slots are inline rather than in a vector. A consumer
+ * finding it empty flags itself waiting and sleeps on tail with a futex;
+ * the producer only makes the wake syscall when it sees that flag.
+ */
+template<typename T, int Capacity>
+class ShardQueue {
+	private:
+		static_assert((Capacity & (Capacity - 1)) == 0, "capacity is a power of two");
+		static_assert(ATOMIC_INT_LOCK_FREE == 2, "futex words are lock free ints");
+		std::atomic<uint32_t> head;    //written by the consumer
+		std::atomic<uint32_t> waiting; //the consumer is in or going into FUTEX_WAIT
+		char pad0[56];
+		std::atomic<uint32_t> tail;    //written by the producer
+		char pad1[60];
+		T slots[Capacity];
+
+		uint32_t* word() {  return reinterpret_cast<uint32_t*>(&tail);  }
+	public:
+		ShardQueue() : head(0), waiting(0), tail(0) { }
+		ShardQueue(const ShardQueue&) = delete;
+		ShardQueue& operator=(const ShardQueue&) = delete;
+
+		void push(const T& value);
+		T pop();
+};
+
+//a full queue only waits for the consumer to take one, which it is about to
+template<typename T, int Capacity>
+void ShardQueue<T, Capacity>::push(const T& value) {
+	uint32_t position = tail.load(std::memory_order_relaxed);
+	while(position - head.load(std::memory_order_acquire) == Capacity)
+		sched_yield();
+	slots[position & (Capacity - 1)] = value;
+	tail.store(position + 1, std::memory_order_release);
+	//pairs with the fence in pop(): either it sees the new tail or this
+	//sees it waiting
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(waiting.load(std::memory_order_relaxed))
+		syscall(SYS_futex, word(), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+template<typename T, int Capacity>
+T ShardQueue<T, Capacity>::pop() {
+	uint32_t position = head.load(std::memory_order_relaxed);
+	uint32_t last;
+	while((last = tail.load(std::memory_order_acquire)) == position) {
+		waiting.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(tail.load(std::memory_order_relaxed) == last)
+			syscall(SYS_futex, word(), FUTEX_WAIT, last, nullptr, nullptr, 0);
+		waiting.store(0, std::memory_order_relaxed);
+	}
+	T value = slots[position & (Capacity - 1)];
+	head.store(position + 1, std::memory_order_release);
+	return value;
+}
+
+/*
+ * Drop-in Network whose cost matrix is split into blocks of rows, one per
+ * worker process, and every line a run prints is the same as with Graph.
+ * Workers are forked by the constructor and stopped by the destructor, they
+ * share one anonymous mapping with the graph:
+ *
+ *   labels       the Boruvka component of each node, -1 for a down node
+ *   per worker   a command queue, a reply queue and the cheapest edge the
+ *                worker's rows have out of each component
+ *
+ * A round sends every worker SHARD_ROUND, each scans its rows for the
+ * cheapest edge leaving every component and the graph keeps the cheapest of
+ * those per component, joins the components they link and relabels. Ties
+ * go by edge list order, so every spanning forest is unique and the rounds
+ * end on the edges Kruskal would add; the repair starts from the union find
+ * names as components and adds its edges in Kruskal's order, which leaves
+ * the same names, name path stacks and adjNodes as Graph.
+ *
+ * The event loop stays in one process since any attack can rename nodes in
+ * every shard; the workers only take part in rebuilds, where a run spends
+ * its time. Linux only.
+ */
+class ShardedGraph {
+	private:
+		typedef ShardQueue<ShardMessage, 4> CommandQueue;
+		typedef ShardQueue<int, 4> ReplyQueue;
+		struct Mailbox {
+			CommandQueue commands;
+			ReplyQueue replies;
+		};
+
+		static int defaultWorkers;
+
+		int numNodes;
+		int seed;
+		int numWorkers;
+		int rowsPerWorker;
+		std::vector<pid_t> workers;
+
+		//the shared mapping, every part starts on a cache line
+		char* shared;
+		std::size_t sharedBytes;
+		std::size_t mailboxBytes;
+		std::size_t workerBytes;
+		static std::size_t lines(std::size_t bytes) {  return (bytes + 63) / 64 * 64;  }
+		int* labels() {  return reinterpret_cast<int*>(shared);  }
+		char* workerPart(int worker) {  return shared + lines(numNodes * sizeof(int)) + worker * workerBytes;  }
+		Mailbox& mailbox(int worker) {  return *reinterpret_cast<Mailbox*>(workerPart(worker));  }
+		ShardEdge* cheapest(int worker) {  return reinterpret_cast<ShardEdge*>(workerPart(worker) + mailboxBytes);  }
+		void serve(int worker);
+		void stopWorkers();
+
+		//the nodes and their containers. Like Graph::nodeBytes() this sizes
+		//only what the constructor carves out, the nodes' adjNodes, name path
+		//stacks and tree rows take the arena's growth blocks
+		Arena arena;
+		static std::size_t nodeBytes(int numNodes) {
+			return (std::size_t)numNodes * sizeof(GraphNode) + 64;  //alignment
+		}
+
+		//node state, downNodes is compromisedNodes | affectedNodes
+		NodeSet compromisedNodes;
+		NodeSet affectedNodes;
+		NodeSet downNodes;
+		uint64_t downHash;           //xor of zobristKey over downNodes
+		std::vector<int> names;      //current union find name of each node
+		std::vector<int> matches;
+		std::vector<int> seenNames;  //componentCount()
+
+		//tree[i] holds the edges where Graph's spanningTree row i is set,
+		//the rows grow in the arena like adjNodes
+		std::vector<ArenaVector<ShardEdge> > tree;
+
+		//Boruvka state, the forest comes out in forest
+		std::vector<int> parent;
+		std::vector<ShardEdge> candidates;
+		std::vector<ShardEdge> forest;
+		int find(int component);
+		void boruvka(bool byName);
+		long long optimalForest();
+
+		long long fakeCost;
+		std::vector<int> missing;
+		ForestCache optimalCache;
+		std::vector<int> noEdges;    //only costs are cached
+
+		bool trackLive;
+		NodeSampler liveNodes;
+
+		//the optimal cost is recomputed when asked for after a change
+		bool trackOptimal;
+		bool optimalStale;
+		long long optimalNow;
+		void nodeDown(int node);
+		void nodeUp(int node);
+
+		void build();
+		void unionSet(int left, int right);
+		void affected(GraphNode* target);
+		void rename(GraphNode* target);
+		void removeFromTree(int node);
+
+	public:
+		//worker processes of a graph made with the two argument constructor
+		static void setDefaultWorkers(int workers) {  defaultWorkers = workers > 0 ? workers : 1;  }
+		static int getDefaultWorkers() {  return defaultWorkers;  }
+
+		GraphNode* nodes;
+		ShardedGraph(int numNodes, int seed) : ShardedGraph(numNodes, seed, defaultWorkers) { }
+		ShardedGraph(int numNodes, int seed, int numWorkers);
+		~ShardedGraph();
+		ShardedGraph(const ShardedGraph&) = delete;
+		ShardedGraph& operator=(const ShardedGraph&) = delete;
+
+		//nodes are never reordered, a slot is its originalName
+		GraphNode* getNode(int node) { return &this->nodes[node]; }
+		int getNumNodes() const { return this->numNodes; }
+		int getNumWorkers() const { return this->numWorkers; }
+
+		//asks the worker holding row i, a round trip per call
+		int getCost(int i, int j);
+
+		//every (i, j) with j < i and an edge i -> j, row by row. Each worker
+		//sends its rows' edges through its cheapest edge buffer, so this takes
+		//a round trip per numNodes edges rather than one per pair
+		void lowerEdges(std::vector<std::pair<int, int> >& edges);
+
+		//the workers' rows are fixed at fork, so this keeps the order
+		void reorderNodes() { }
+
+		void rebuild();
+		void attacked(GraphNode* target);
+		void fixed(GraphNode* target);
+		bool partitioned();
+		int componentCount();
+		bool isCompromised(int node) const { return this->compromisedNodes.test(node); }
+		bool isAffected(int node) const { return this->affectedNodes.test(node); }
+		bool isDown(int node) const { return this->downNodes.test(node); }
+		int getCurrentName(int node) const { return this->names[node]; }
+
+		void setTrackLive(bool track);
+		int numLiveTargets() const { return this->liveNodes.size(); }
+		int liveTarget(int index) const { return this->liveNodes.at(index); }
+
+		void setTrackOptimal(bool track);
+		long long currentOptimalCost();
+
+		//costs of optimal forests remembered by down set, 0 turns it off
+		void setOptimalCache(int entries) { this->optimalCache.setCapacity(entries); }
+		const ForestCache& getOptimalCache() const { return this->optimalCache; }
+
+		const Arena& getArena() const { return this->arena; }
+
+		long long spanningTreeCost() const;
+		long long optimalCost() const { return this->fakeCost; }
+		const std::vector<int>& missingNodes();
+};
+
+int ShardedGraph::defaultWorkers = 4;
+
+ShardedGraph::ShardedGraph(int numNodes, int seed, int numWorkers) : numNodes(numNodes), seed(seed),
+	shared(nullptr), arena(nodeBytes(numNodes)), compromisedNodes(numNodes), affectedNodes(numNodes),
+	downNodes(numNodes), downHash(0), names(numNodes), matches(numNodes), seenNames(numNodes), tree(numNodes, ArenaVector<ShardEdge>(&arena)), parent(numNodes),
+	fakeCost(0), optimalCache(Graph::DEFAULT_OPTIMAL_CACHE, numNodes), trackLive(false),
+	trackOptimal(false), optimalStale(true), optimalNow(0) {
+	//every worker gets at least one row
+	this->numWorkers = std::max(1, std::min(numWorkers, numNodes));
+	rowsPerWorker = (numNodes + this->numWorkers - 1) / this->numWorkers;
+
+	nodes = arena.allocateArray<GraphNode>(numNodes);
+	for(int i = 0; i < numNodes; i++) {
+		new (&nodes[i]) GraphNode(&arena);
+		nodes[i].originalName = nodes[i].index = names[i] = i;
+		nodes[i].namePathStack.push(i);
+	}
+	candidates.reserve(numNodes);
+	forest.reserve(numNodes);
+	missing.reserve(numNodes);
+
+	mailboxBytes = lines(sizeof(Mailbox));
+	workerBytes = mailboxBytes + lines(numNodes * sizeof(ShardEdge));
+	sharedBytes = lines(numNodes * sizeof(int)) + this->numWorkers * workerBytes;
+	void* mapping = mmap(nullptr, sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(mapping == MAP_FAILED)
+		throw std::runtime_error("cannot map shard memory");
+	shared = static_cast<char*>(mapping);
+	for(int w = 0; w < this->numWorkers; w++)
+		new (&mailbox(w)) Mailbox();
+
+	for(int w = 0; w < this->numWorkers; w++) {
+		pid_t pid = fork();
+		if(pid == 0)
+			serve(w);
+		if(pid == -1) {
+			stopWorkers();
+			throw std::runtime_error("cannot fork shard worker");
+		}
+		workers.push_back(pid);
+	}
+
+	build();
+}
+
+ShardedGraph::~ShardedGraph() {
+	stopWorkers();
+}
+
+void ShardedGraph::stopWorkers() {
+	ShardMessage exit = {SHARD_EXIT, 0, 0};
+	for(unsigned int w = 0; w < workers.size(); w++)
+		mailbox(w).commands.push(exit);
+	for(unsigned int w = 0; w < workers.size(); w++)
+		waitpid(workers[w], nullptr, 0);
+	workers.clear();
+	if(shared)
+		munmap(shared, sharedBytes);
+	shared = nullptr;
+}
+
+/*
+ * A worker's whole life: generate its rows, then answer commands until told
+ * to exit. It never returns into the code that forked it, and dies with the
+ * graph's process if that goes first.
+ */
+void ShardedGraph::serve(int worker) {
+	pid_t owner = getppid();
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+	if(getppid() != owner)
+		_exit(1);
+
+	try {
+		int first = worker * rowsPerWorker;
+		int last = std::min(numNodes, first + rowsPerWorker);
+		std::size_t n = numNodes;
+		std::vector<signed char> cells((last - first) * n);
+		randomNetworkRows(numNodes, seed, [&](int i) -> signed char* {
+			return (i >= first && i < last) ? &cells[(i - first) * n] : nullptr;
+		});
+
+		Mailbox& box = mailbox(worker);
+		ShardEdge* best = cheapest(worker);
+		const int* label = labels();
+		while(true) {
+			ShardMessage command = box.commands.pop();
+			if(command.type == SHARD_EXIT)
+				break;
+			if(command.type == SHARD_COST) {
+				box.replies.push(cells[(command.left - first) * n + command.right]);
+				continue;
+			}
+			if(command.type == SHARD_EDGES) {
+				int count = 0;
+				int j = command.right;
+				for(int i = command.left; i < last && count < numNodes; i++, j = 0)
+					for(; j < i && count < numNodes; j++)
+						if(cells[(i - first) * n + j] != 0)
+							best[count++] = ShardEdge{cells[(i - first) * n + j], i, j};
+				box.replies.push(count);
+				continue;
+			}
+
+			//rows and columns go up, so the first cheapest edge seen is also
+			//first in edge list order
+			for(int c = 0; c < numNodes; c++)
+				best[c].cost = 0;
+			for(int i = first; i < last; i++) {
+				int from = label[i];
+				if(from < 0)
+					continue;
+				const signed char* row = &cells[(i - first) * n];
+				for(int j = 0; j < numNodes; j++) {
+					int cost = row[j];
+					if(cost == 0)
+						continue;
+					int to = label[j];
+					if(to < 0 || to == from)
+						continue;
+					if(best[from].cost == 0 || cost < best[from].cost)
+						best[from] = ShardEdge{cost, i, j};
+					if(best[to].cost == 0 || cost < best[to].cost)
+						best[to] = ShardEdge{cost, i, j};
+				}
+			}
+			box.replies.push(0);
+		}
+	} catch(...) {
+		_exit(1);
+	}
+	_exit(0);
+}
+
+int ShardedGraph::getCost(int i, int j) {
+	int worker = i / rowsPerWorker;
+	ShardMessage query = {SHARD_COST, i, j};
+	mailbox(worker).commands.push(query);
+	return mailbox(worker).replies.pop();
+}
+
+//a full buffer means the worker may have more, asked for from just past
+//the last edge it sent
+void ShardedGraph::lowerEdges(std::vector<std::pair<int, int> >& edges) {
+	for(int w = 0; w < numWorkers; w++) {
+		ShardMessage query = {SHARD_EDGES, w * rowsPerWorker, 0};
+		while(true) {
+			mailbox(w).commands.push(query);
+			int count = mailbox(w).replies.pop();
+			const ShardEdge* sent = cheapest(w);
+			for(int k = 0; k < count; k++)
+				edges.push_back(std::make_pair(sent[k].left, sent[k].right));
+			if(count < numNodes)
+				break;
+			query.left = sent[count - 1].left;
+			query.right = sent[count - 1].right + 1;
+		}
+	}
+}
+
+int ShardedGraph::find(int component) {
+	while(parent[component] != component) {
+		parent[component] = parent[parent[component]];
+		component = parent[component];
+	}
+	return component;
+}
+
+/*
+ * Minimum spanning forest of the live nodes in edge list order. With byName
+ * every union find set starts as one component, which is the forest Graph's
+ * build() completes. Without it every node starts alone, as fakeBuild()
+ * does. Leaves the edges in forest.
+ */
+void ShardedGraph::boruvka(bool byName) {
+	int* label = labels();
+	for(int i = 0; i < numNodes; i++) {
+		label[i] = downNodes.test(i) ? -1 : (byName ? names[i] : i);
+		parent[i] = i;
+	}
+	forest.clear();
+
+	ShardMessage round = {SHARD_ROUND, 0, 0};
+	while(true) {
+		for(int w = 0; w < numWorkers; w++)
+			mailbox(w).commands.push(round);
+		for(int w = 0; w < numWorkers; w++)
+			mailbox(w).replies.pop();
+
+		candidates.clear();
+		for(int c = 0; c < numNodes; c++) {
+			ShardEdge pick = {0, 0, 0};
+			for(int w = 0; w < numWorkers; w++) {
+				const ShardEdge& edge = cheapest(w)[c];
+				if(edge.cost != 0 && (pick.cost == 0 || edge < pick))
+					pick = edge;
+			}
+			if(pick.cost != 0)
+				candidates.push_back(pick);
+		}
+		if(candidates.empty())
+			break;
+
+		//both components of an edge may have picked it
+		for(unsigned int k = 0; k < candidates.size(); k++) {
+			int from = find(label[candidates[k].left]);
+			int to = find(label[candidates[k].right]);
+			if(from != to) {
+				parent[std::max(from, to)] = std::min(from, to);
+				forest.push_back(candidates[k]);
+			}
+		}
+		for(int i = 0; i < numNodes; i++)
+			if(label[i] >= 0)
+				label[i] = find(label[i]);
+	}
+}
+
+long long ShardedGraph::optimalForest() {
+	boruvka(false);
+	long long total = 0;
+	for(unsigned int k = 0; k < forest.size(); k++)
+		total += forest[k].cost;
+	return total;
+}
+
+//the edges Kruskal would add, added in the order it would add them
+void ShardedGraph::build() {
+	boruvka(true);
+	std::sort(forest.begin(), forest.end());
+	for(unsigned int k = 0; k < forest.size(); k++) {
+		const ShardEdge& edge = forest[k];
+		unionSet(edge.left, edge.right);
+		ArenaVector<ShardEdge>& row = tree[edge.left];
+		bool present = false;
+		for(unsigned int e = 0; e < row.size() && !present; e++)
+			present = row[e].right == edge.right;
+		if(!present)
+			row.push_back(edge);
+	}
+}
+
+void ShardedGraph::unionSet(int left, int right) {
+	nodes[left].adjNodes.push_back(&nodes[right]);
+	nodes[right].adjNodes.push_back(&nodes[left]);
+
+	//the larger name is relabelled to the smaller one
+	int oldName = names[right];
+	int newName = names[left];
+	int via = left;
+	if(names[left] >= names[right]) {
+		oldName = names[left];
+		newName = names[right];
+		via = right;
+	}
+
+	int found = findEqual(names.data(), numNodes, oldName, matches.data());
+	for(int i = 0; i < found; i++) {
+		names[matches[i]] = newName;
+		nodes[matches[i]].namePathStack.push(via);
+	}
+}
+
+void ShardedGraph::rebuild() {
+	{
+		STATS_TIME_REPAIR();
+		build();
+	}
+	{
+		STATS_TIME_OPTIMAL();
+		const CachedForest* cached = optimalCache.find(downHash, downNodes);
+		STATS_OPTIMAL_CACHE(cached != nullptr);
+		if(cached) {
+			fakeCost = cached->cost;
+		} else {
+			fakeCost = optimalForest();
+			optimalCache.insert(downHash, downNodes, fakeCost, noEdges);
+		}
+	}
+}
+
+void ShardedGraph::fixed(GraphNode* target) {
+	STATS_TIME_OP(OP_FIXED);
+	int node = target->index;
+	compromisedNodes.reset(node);
+	affectedNodes.reset(node);
+	if(trackLive)
+		liveNodes.insert(node);
+	nodeUp(node);
+}
+
+void ShardedGraph::attacked(GraphNode* target) {
+	STATS_TIME_OP(OP_ATTACKED);
+	compromisedNodes.set(target->index);
+	if(trackLive)
+		liveNodes.erase(target->index);
+	nodeDown(target->index);
+	for(unsigned int i = 0; i < target->adjNodes.size(); i++)
+		this->affected(target->adjNodes[i]);
+	this->removeFromTree(target->index);
+	this->rename(target);
+}
+
+void ShardedGraph::affected(GraphNode* target) {
+	affectedNodes.set(target->index);
+	nodeDown(target->index);
+	this->removeFromTree(target->index);
+	this->rename(target);
+}
+
+void ShardedGraph::nodeDown(int node) {
+	if(downNodes.test(node))
+		return;
+	downNodes.set(node);
+	downHash ^= zobristKey(node);
+	optimalStale = true;
+}
+
+void ShardedGraph::nodeUp(int node) {
+	if(!downNodes.test(node))
+		return;
+	downNodes.reset(node);
+	downHash ^= zobristKey(node);
+	optimalStale = true;
+}
+
+//its row and every entry of it in the other rows
+void ShardedGraph::removeFromTree(int node) {
+	tree[node].clear();
+	for(int i = 0; i < numNodes; i++) {
+		ArenaVector<ShardEdge>& row = tree[i];
+		for(unsigned int e = 0; e < row.size(); e++)
+			if(row[e].right == node) {
+				row[e] = row.back();
+				row.pop_back();
+				break;
+			}
+	}
+}
+
+//Graph::rename()
+void ShardedGraph::rename(GraphNode* target) {
+	const ArenaVector<GraphNode*>& tempNodes = target->adjNodes;
+	if(downNodes.test(target->index))
+		names[target->index] = target->index;
+
+	for(unsigned int i = 0; i < tempNodes.size(); i++) {
+		GraphNode* tempNode = tempNodes[i];
+		int& currentName = names[tempNode->index];
+		while((currentName != tempNode->index) && downNodes.test(currentName)) {
+			int index = tempNode->namePathStack.top();
+			if(tempNode->namePathStack.size() == 1)
+				currentName = index;
+			else if(downNodes.test(index))
+				tempNode->namePathStack.pop();
+			else
+				currentName = index;
+		}
+	}
+}
+
+//Graph::partitioned(): the nodes with a tree row must all share the name of
+//the first tree entry's second node
+bool ShardedGraph::partitioned() {
+	STATS_TIME_OP(OP_PARTITIONED);
+	int first = -1;
+	for(int i = 0; i < numNodes && first == -1; i++)
+		for(unsigned int e = 0; e < tree[i].size(); e++)
+			if(first == -1 || tree[i][e].right < first)
+				first = tree[i][e].right;
+	if(first != -1)
+		for(int i = 0; i < numNodes; i++)
+			if(!tree[i].empty() && names[i] != names[first]) {
+				std::cout << "The tree is partitioned." << std::endl;
+				return true;
+			}
+	std::cout << "The tree is complete." << std::endl;
+	return false;
+}
+
+int ShardedGraph::componentCount() {
+	std::fill(seenNames.begin(), seenNames.end(), 0);
+	int components = 0;
+	for(int i = 0; i < numNodes; i++) {
+		if(downNodes.test(i) || seenNames[names[i]])
+			continue;
+		seenNames[names[i]] = 1;
+		components++;
+	}
+	return components;
+}
+
+void ShardedGraph::setTrackLive(bool track) {
+	if(track && !trackLive) {
+		liveNodes = NodeSampler(numNodes);
+		for(int i = 0; i < numNodes; i++)
+			if(!compromisedNodes.test(i))
+				liveNodes.insert(i);
+	}
+	trackLive = track;
+}
+
+void ShardedGraph::setTrackOptimal(bool track) {
+	trackOptimal = track;
+	optimalStale = true;
+}
+
+long long ShardedGraph::currentOptimalCost() {
+	if(optimalStale) {
+		optimalNow = optimalForest();
+		optimalStale = false;
+	}
+	return optimalNow;
+}
+
+long long ShardedGraph::spanningTreeCost() const {
+	long long total = 0;
+	for(int i = 0; i < numNodes; i++)
+		for(unsigned int e = 0; e < tree[i].size(); e++)
+			total += tree[i][e].cost;
+	return total;
+}
+
+//filled into a buffer the graph keeps, valid until the next call
+const std::vector<int>& ShardedGraph::missingNodes() {
+	missing.clear();
+	downNodes.list(missing);
+	return missing;
+}
+#endif
@@ -0,0 +1,505 @@
+//discrete event simulator of the attacked computer network
+//the simulator is templated on its backends so a configuration is chosen at
+//compile time and the fetch-execute loop is specialized for it
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+#include "pqueue.hpp"
+#include "graph.hpp"
+#include "smallgraph.hpp"
+#include "shard.hpp"
+#include "sysadmin.cpp"
+#include "stats.hpp"
+#include "rng.hpp"
+#include "connectivity.hpp"
+#include "feed.hpp"
+#include "metrics.hpp"
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+enum ACTION {
+	EXECUTE_ATTACK = 5,
+	DEPLOY_ATTACK = 4,
+	EXECUTE_FIX = 3,
+	DEPLOY_FIX = 2,
+	EXECUTE_REBUILD = 1,
+	DEPLOY_REBUILD = 0
+};
+
+struct Event {
+	ACTION action;
+	GraphNode* source = nullptr;
+	GraphNode* target = nullptr;
+	int agent = 0; //attacker or sysadmin that owns the event
+};
+
+inline bool tiebreaker(Event& x1, int p1, Event& x2, int p2) {
+	return x1.action > x2.action;
+}
+
+/*
+ * Policies the simulator is built from. Each one is held by value.
+ * Scheduler: push(Event&, long long), pop() -> PriorityContainer<Event>,
+ *            peekPriority(), peekContent(), isEmpty(), size()
+ * Network:   Network(numNodes, seed), getNode, getCost, lowerEdges, attacked, fixed,
+ *            partitioned, rebuild and the rebuild report methods of Graph;
+ *            Graph, SmallGraph<MaxNodes> or ShardedGraph
+ * FixQueue:  FixQueue(numNodes), push, pop, check, isEmpty, size
+ * RNG:       RNG(seed, numStreams), uniform(stream, low, high); attacker i
+ *            draws from stream i, sysadmin j from stream numAttackers + j
+ */
+template<typename Scheduler = PriorityQueue<Event, tiebreaker>,
+         typename Network = Graph,
+         typename FixQueue = SysAdmin,
+         typename RNG = MersenneRNG>
+class BasicSimulator {
+	private:
+		//input values
+		int numAttackers;
+		int numSysadmins;
+		int numComputers;
+		int seed;
+
+		//time and number of attack
+		int t;
+		int numAttack;
+		long long numEvents = 0;
+		bool started = false;
+
+		//Agent and queue
+		Network computerNetwork;
+		FixQueue sysAdminsQueue; 
+		Scheduler pq;
+		bool checkRebuild = false;
+		bool sysAdminsDeployed = false;
+
+		//Attack batching: attacks sharing a timestamp are applied first and
+		//the network is checked for a partition once afterwards. This is a
+		//different run from the sequential one, not a faster copy of it: a
+		//partition healed by a later attack of the tick schedules no rebuild,
+		//and the Deploy_Rebuild pushed later lands elsewhere in the heap,
+		//which can reorder events that tie on time and action
+		bool batchAttacks = false;
+		bool pendingPartitionCheck = false;
+		long long numPartitionChecks = 0;
+		bool attackPending();
+		void checkPartition();
+
+		//Node up/down history for offline analysis
+		bool recordRun = false;
+		RunRecording recording;
+
+		//Rebuild reports also appended to a columnar file when set
+		MetricsWriter* metrics = nullptr;
+
+		//Optimal cost after every attack and fix
+		bool trackOptimal = false;
+		void reportOptimal() {
+			if(this->trackOptimal)
+				std::cout << "Optimal_Cost(" << t << "): " << computerNetwork.currentOptimalCost() << std::endl;
+		}
+
+		//Randocm number generation
+		RNG mt;
+		int randomDelay(int agent, int low, int high) {  return this->mt.uniform(agent, low, high);  }
+		//Fetch-Execute cycle
+		Event fetch();
+		void process(Event& e);
+
+		//Schedule methods
+		void scheduleDeployAttack(int attacker);
+		void scheduleExecuteAttack(GraphNode* target, int attacker);
+		void scheduleDeployFix(int sysadmin);
+		void scheduleExecuteFix(GraphNode* target, int sysadmin);
+		void scheduleDeployRebuild();
+		void scheduleExecuteRebuild();
+
+		//Process methods
+		void processDeployAttack(Event& e);
+		void processExecuteAttack(Event& e);
+		void processDeployFix(Event& e);
+		void processExecuteFix(Event& e);
+		void processDeployRebuild(Event& e);
+		void processExecuteRebuild(Event& e);
+
+		//External attacks: with a feed the attackers are not deployed, every
+		//record becomes one EXECUTE_ATTACK and the run ends with the feed
+		AttackFeed* feed = nullptr;
+		bool feedDone = false;
+		long long numFeedSkipped = 0;
+		void scheduleFeedAttack();
+
+		//attackers only pick uncompromised nodes when sampleLive is set
+		bool sampleLive = false;
+		int randomComputer(int agent) {
+			if(this->sampleLive && computerNetwork.numLiveTargets() > 0)
+				return computerNetwork.liveTarget(this->mt.uniform(agent, 0, computerNetwork.numLiveTargets() - 1));
+			return this->mt.uniform(agent, 0, numComputers - 1);
+		}
+
+	public:
+		BasicSimulator(int numAttackers, int numSysadmins, int numComputers, int seed);
+		void setBatchAttacks(bool batch) { this->batchAttacks = batch; }
+		void setRecordRun(bool record) { this->recordRun = record; }
+		//Appends every rebuild report to metrics as well, before the run
+		void setMetrics(MetricsWriter* metrics) { this->metrics = metrics; }
+		void setSampleLive(bool live) {
+			this->sampleLive = live;
+			computerNetwork.setTrackLive(live);
+		}
+		void setTrackOptimal(bool track) {
+			this->trackOptimal = track;
+			computerNetwork.setTrackOptimal(track);
+		}
+		//Takes the attacks from feed instead of the attackers, before the run
+		void setAttackFeed(AttackFeed* feed) { this->feed = feed; }
+		const RunRecording& getRecording() const { return this->recording; }
+		std::vector<ConnectivitySnapshot> analyzeConnectivity();
+
+		//Entry points
+		void start();
+		bool step();
+		void runUntil(int time);
+		void run();
+
+		bool finished() const { return this->feed ? this->feedDone : this->numAttack >= 2000; }
+		int getTime() const { return this->t; }
+		long long getNumEvents() const { return this->numEvents; }
+		long long getNumPartitionChecks() const { return this->numPartitionChecks; }
+		long long getNumFeedSkipped() const { return this->numFeedSkipped; }
+		Network& getNetwork() { return this->computerNetwork; }
+#ifdef SIMULATION_STATS
+		const Stats& getStats() const { return simulationStats(); }
+#endif
+};
+
+//The default configuration
+using Simulator = BasicSimulator<>;
+		
+//Constructor
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+BasicSimulator<Scheduler, Network, FixQueue, RNG>::BasicSimulator(int numAttackers, int numSysadmins, int numComputers, int seed)
+	: computerNetwork(numComputers, seed), sysAdminsQueue(numComputers),
+	  mt(seed, numAttackers + numSysadmins) {
+	this->numAttackers = numAttackers;
+	this->numSysadmins = numSysadmins;
+	this->numComputers = numComputers;
+	this->seed = seed;
+
+	this->t= 0;
+	this->numAttack = 0;
+	//one pending wake up per agent and two for the rebuild at most, so
+	//the scheduler never grows mid run
+	this->pq.reserve(numAttackers + numSysadmins + 2);
+}
+
+//Deploys the attackers, called once by the other entry points
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::start() {
+	if(this->started)
+		return;
+	this->started = true;
+
+	std::cout << "STARTING SIMULATION" << std::endl;
+	if(this->feed) {
+		this->scheduleFeedAttack();
+		return;
+	}
+	for(int i = 0; i < numAttackers;i++) 
+		this->scheduleDeployAttack(i);
+}
+
+//Processes the next event, false if there is none
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+bool BasicSimulator<Scheduler, Network, FixQueue, RNG>::step() {
+	this->start();
+	if(pq.isEmpty())
+		return false;
+
+	Event fetched = this->fetch();
+	this->process(fetched);
+	(this->numEvents)++;
+	if(this->pendingPartitionCheck && !this->attackPending())
+		this->checkPartition();
+	STATS_EVENT(pq.size(), sysAdminsQueue.size());
+	return true;
+}
+
+//Whether another attack will run at the current time. Attacks outrank
+//every other action on a tie, so they always run before fixes and rebuilds
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+bool BasicSimulator<Scheduler, Network, FixQueue, RNG>::attackPending() {
+	if(this->finished() || pq.isEmpty() || pq.peekPriority() != this->t)
+		return false;
+	ACTION next = pq.peekContent().action;
+	return next == EXECUTE_ATTACK || next == DEPLOY_ATTACK;
+}
+
+//rebuild when the spanning tree is partitioned
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::checkPartition() {
+	this->pendingPartitionCheck = false;
+	(this->numPartitionChecks)++;
+	if(computerNetwork.partitioned())
+		this->scheduleDeployRebuild();
+}
+
+//Processes every event scheduled up to and including time, stopping early
+//at the stopping condition
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::runUntil(int time) {
+	this->start();
+	while(!this->finished() && !pq.isEmpty() && pq.peekPriority() <= time)
+		this->step();
+}
+
+//Runs the simulation until 2000 attacks have occurred, or the attack feed
+//has run out
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::run() {
+	this->start();
+	while(!this->finished()) {
+		if(!this->step())
+			break;
+	}
+	std::cout << "ATTACK FINISHED" << std::endl;
+}
+
+//Components and largest component of the surviving network at every
+//timestamp of the recorded run
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+std::vector<ConnectivitySnapshot> BasicSimulator<Scheduler, Network, FixQueue, RNG>::analyzeConnectivity() {
+	std::vector<std::pair<int, int> > edges;
+	computerNetwork.lowerEdges(edges);
+	ConnectivityAnalysis analysis(numComputers, edges, recording);
+	return analysis.getSnapshots();
+}
+
+//The fetch part of the fetch-execute cycle
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+Event BasicSimulator<Scheduler, Network, FixQueue, RNG>::fetch() {
+	auto next = pq.pop();
+	this->t = next.priority;
+	return next.content;
+}
+
+//The execute part of the fetch-execute cycle
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::process(Event& e) {
+	STATS_TIME_EVENT(e.action);
+
+	switch(e.action) {
+		case EXECUTE_ATTACK:
+			this->processExecuteAttack(e);
+			break;
+		case DEPLOY_ATTACK:
+			this->processDeployAttack(e);
+			break;
+		case EXECUTE_FIX:
+			this->processExecuteFix(e);
+			break;
+		case DEPLOY_FIX:
+			this->processDeployFix(e);
+			break;
+		case EXECUTE_REBUILD:
+			this->processExecuteRebuild(e);
+			break;
+		case DEPLOY_REBUILD:
+			this->processDeployRebuild(e);
+			break;
+	}
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleDeployAttack(int attacker) {
+	//std::cout << "is this working" << std::endl;
+	Event e;
+	e.action = DEPLOY_ATTACK;
+	e.agent = attacker;
+	e.target = computerNetwork.getNode(this->randomComputer(attacker));
+	int t = this->t + this->randomDelay(attacker, 100, 1000);
+	//std::cout << "current time attack " << time << std::endl;
+	this->pq.push(e, t);
+	std::cout << "Deploy_Attack(" << t << ", " << e.target->originalName << ")" << std::endl;
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleExecuteAttack(GraphNode* target, int attacker) {
+	//std::cout << "this is working" << std::endl;
+	Event e;
+	e.action = EXECUTE_ATTACK;
+	e.agent = attacker;
+	e.target = target;
+	this->pq.push(e, this->t);
+	(this->numAttack)++;
+	std::cout << "Execute_Attack(" << t << ", " << e.target->originalName << ")" << std::endl;
+}
+
+//Schedules the next record of the feed. A record for a node outside the
+//network is skipped, one timed before now runs now
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleFeedAttack() {
+	AttackRecord record;
+	while(this->feed->next(record)) {
+		if(record.target >= numComputers) {
+			(this->numFeedSkipped)++;
+			continue;
+		}
+		Event e;
+		e.action = EXECUTE_ATTACK;
+		e.target = computerNetwork.getNode(record.target);
+		int t = record.time > this->t ? record.time : this->t;
+		this->pq.push(e, t);
+		(this->numAttack)++;
+		std::cout << "Execute_Attack(" << t << ", " << e.target->originalName << ")" << std::endl;
+		return;
+	}
+	this->feedDone = true;
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleDeployFix(int sysadmin) {
+	//std::cout << "helloooo work please" << std::endl;
+	Event e;
+	e.action = DEPLOY_FIX;
+	e.agent = sysadmin;
+	int t = this->t + this->randomDelay(sysadmin, 1000, 2000);
+	this->pq.push(e, t);
+	std::cout << "Deploy_Fix(" << t << ")" << std::endl;
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleExecuteFix(GraphNode* target, int sysadmin) {
+	//std::cout << "fix scheduled" << std::endl;
+	Event e;
+	e.action = EXECUTE_FIX;
+	e.agent = sysadmin;
+	e.target = target;
+	this->pq.push(e, this->t);
+	std::cout << "Execute_Repair(" << e.target->originalName << ")" << std::endl;
+}
+
+//Rebuild is executed when NOT on the queueu
+//checked by bool variable checkRebuild
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleDeployRebuild() {
+	//std::cout << "rebuild scheduled" << std::endl;
+	if(!(this->checkRebuild)) {
+		Event e;
+		e.action = DEPLOY_REBUILD;
+		int t = this->t + 20;
+		this->pq.push(e, t);
+		std::cout << "Deploy_Rebuild(" << t << ")" << std::endl;
+	}
+	this->checkRebuild=true;
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::scheduleExecuteRebuild() {
+	//std::cout << "scheduleExecutebuild" << std::endl;
+	Event e;
+	e.action = EXECUTE_REBUILD;
+	this->pq.push(e,t);
+	std::cout << "Execute_Rebuild(" << t << ")" << std::endl;
+}
+
+//The processor method to handle the execution of the events
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processDeployAttack(Event &e) {
+	this->scheduleExecuteAttack(e.target, e.agent);
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processExecuteAttack(Event &e) {
+	GraphNode* tempNode = e.target;
+	const ArenaVector<GraphNode*>& adjNodes = tempNode->adjNodes;
+
+	if(this->recordRun) {
+		recording.nodeDown(t, tempNode->originalName);
+		for(unsigned int i = 0; i < adjNodes.size(); i++)
+			recording.nodeDown(t, adjNodes[i]->originalName);
+	}
+
+	//queue compromised and affected node first before real attack
+	//re-broken machines don't get a re-entry
+	if(!sysAdminsQueue.check(tempNode))
+		sysAdminsQueue.push(tempNode); //push on sysadmin fix queue
+	for(unsigned int i = 0; i < adjNodes.size(); i++)
+		if(!sysAdminsQueue.check(adjNodes[i]))
+			sysAdminsQueue.push(adjNodes[i]);
+	
+	computerNetwork.attacked(tempNode);
+	this->reportOptimal();
+
+	//sysadmins start fixing after the first node is compromised
+	if(!sysAdminsDeployed) {
+		for(int i = 0; i < numSysadmins; i++)
+			this->scheduleDeployFix(numAttackers + i);
+		sysAdminsDeployed = true;
+	}
+
+	//a scheduled rebuild already covers this attack, otherwise the check
+	//waits for the last attack at this time when batching
+	if(this->batchAttacks) {
+		if(!this->checkRebuild)
+			this->pendingPartitionCheck = true;
+	} else {
+		this->checkPartition();
+	}
+	if(this->feed)
+		this->scheduleFeedAttack();
+	else
+		this->scheduleDeployAttack(e.agent);
+}
+
+//nothing to fix, the sysadmin checks again later
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processDeployFix(Event &e) {	
+	if(sysAdminsQueue.isEmpty()) {
+		this->scheduleDeployFix(e.agent);
+		return;
+	}
+	this->scheduleExecuteFix(sysAdminsQueue.pop(), e.agent);
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processExecuteFix(Event &e) {
+	computerNetwork.fixed(e.target);
+	this->reportOptimal();
+	if(this->recordRun)
+		recording.nodeUp(t, e.target->originalName);
+	this->scheduleDeployRebuild();
+	this->scheduleDeployFix(e.agent);
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processDeployRebuild(Event &e) {
+	this->scheduleExecuteRebuild();
+}
+
+template<typename Scheduler, typename Network, typename FixQueue, typename RNG>
+void BasicSimulator<Scheduler, Network, FixQueue, RNG>::processExecuteRebuild(Event &e) {
+	this->computerNetwork.rebuild();
+	this->checkRebuild = false;
+	//the stats sample and the metrics row share one pass over the nodes
+	bool counting = this->metrics != nullptr;
+#ifdef SIMULATION_STATS
+	counting = true;
+#endif
+	int components = counting ? computerNetwork.componentCount() : 0;
+	STATS_SAMPLE(t, pq.size(), sysAdminsQueue.size(), components);
+
+	const std::vector<int>& missing = computerNetwork.missingNodes();
+	long long treeCost = computerNetwork.spanningTreeCost();
+	std::cout << "Spanning tree cost is " << treeCost << ". Missing nodes:";
+	for(unsigned int i = 0; i < missing.size(); i++)
+		std::cout << " " << missing[i];
+	std::cout << std::endl;
+	std::cout << "Optimal MST cost is " << computerNetwork.optimalCost() << "." << std::endl;
+	if(this->metrics)
+		this->metrics->append(t, treeCost, computerNetwork.optimalCost(), components, missing);
+}
+
+#endif
@@ -0,0 +1,536 @@
+//graph for small networks, sized at compile time
+//the same network, spanning tree and union find names as Graph, with node
+//state, adjacency and the tree kept as rows of at most MaxNodes bits, so
+//removing a node from the tree or checking for a partition is a few word
+//operations. Both the repair and the optimal forest come from Prim over
+//the bit rows instead of a pass over the sorted edge list
+
+#ifndef SMALLGRAPH_H
+#define SMALLGRAPH_H
+#include "graph.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+//fixed size set of nodes, one bit each
+template<int MaxNodes>
+struct SmallSet {
+	static const int WORDS = (MaxNodes + 63) / 64;
+	uint64_t words[WORDS];
+
+	void clear() {
+		for(int w = 0; w < WORDS; w++)
+			words[w] = 0;
+	}
+	bool test(int node) const {  return (words[node >> 6] >> (node & 63)) & 1;  }
+	void set(int node) {  words[node >> 6] |= (uint64_t)1 << (node & 63);  }
+	void reset(int node) {  words[node >> 6] &= ~((uint64_t)1 << (node & 63));  }
+
+	bool any() const {
+		uint64_t all = 0;
+		for(int w = 0; w < WORDS; w++)
+			all |= words[w];
+		return all != 0;
+	}
+
+	//smallest member, -1 when empty
+	int first() const {
+		for(int w = 0; w < WORDS; w++)
+			if(words[w])
+				return w * 64 + __builtin_ctzll(words[w]);
+		return -1;
+	}
+
+	SmallSet& operator|=(const SmallSet& other) {
+		for(int w = 0; w < WORDS; w++)
+			words[w] |= other.words[w];
+		return *this;
+	}
+	SmallSet operator&(const SmallSet& other) const {
+		SmallSet result;
+		for(int w = 0; w < WORDS; w++)
+			result.words[w] = words[w] & other.words[w];
+		return result;
+	}
+	SmallSet without(const SmallSet& other) const {
+		SmallSet result;
+		for(int w = 0; w < WORDS; w++)
+			result.words[w] = words[w] & ~other.words[w];
+		return result;
+	}
+
+	//calls visit with every member, smallest first
+	template<typename Visit>
+	void forEach(Visit visit) const {
+		for(int w = 0; w < WORDS; w++) {
+			uint64_t word = words[w];
+			while(word) {
+				visit(w * 64 + __builtin_ctzll(word));
+				word &= word - 1;
+			}
+		}
+	}
+};
+
+/*
+ * Drop-in Network for networks of at most MaxNodes nodes (256 at most, so
+ * an edge's rank fits 16 bits). Generated from the seed exactly like Graph
+ * and every line a run prints is the same as with Graph.
+ *
+ * The edges are ranked once by cost, equal costs in edge list order, which
+ * is the order Graph's Kruskal takes them in. With that rank as the weight
+ * every spanning forest is unique, so Prim finds the edges Kruskal would
+ * add, and adding them to the union find in rank order leaves the same
+ * names, name path stacks and adjNodes.
+ */
+template<int MaxNodes>
+class SmallGraph {
+	private:
+		typedef SmallSet<MaxNodes> Set;
+		static const uint16_t NO_EDGE = 0xffff;
+
+		int numNodes;
+
+		//the nodes and their containers, with room for every node's adjNodes
+		//and name path stack to start at about 2n entries, later growth
+		//opens further blocks
+		Arena arena;
+		static std::size_t nodeBytes(int numNodes) {
+			std::size_t n = numNodes;
+			return n * sizeof(GraphNode) + 4 * n * n * (sizeof(GraphNode*) + sizeof(int)) + 64;
+		}
+
+		//node state, downNodes is compromisedNodes | affectedNodes
+		Set allNodes;
+		Set compromisedNodes;
+		Set affectedNodes;
+		Set downNodes;
+
+		//current union find name of each node, and the nodes holding each name
+		int names[MaxNodes];
+		Set members[MaxNodes];
+
+		//adjacent has i and j in each other's rows when either direction is
+		//an edge, forward has j in row i when i -> j is the cheaper direction,
+		//the one both forests use. cost is the adjacency matrix
+		Set adjacent[MaxNodes];
+		Set forward[MaxNodes];
+		unsigned char cost[MaxNodes][MaxNodes];
+		uint16_t rank[MaxNodes][MaxNodes];   //of the cheaper direction
+
+		//tree has j in row i where Graph's spanningTree[i][j] is set
+		Set tree[MaxNodes];
+
+		//Prim scratch, the forest comes out in chosen
+		struct ForestEdge {
+			int rank;
+			int left;
+			int right;
+			bool operator<(const ForestEdge& other) const {  return rank < other.rank;  }
+		};
+		int key[MaxNodes];
+		int from[MaxNodes];
+		ForestEdge chosen[MaxNodes];
+		int primForest(bool byName);
+		long long optimalForest();
+
+		long long fakeCost;
+		std::vector<int> missing;
+		ForestCache optimalCache;
+
+		bool trackLive;
+		NodeSampler liveNodes;
+
+		//the optimal cost is recomputed when asked for after a change
+		bool trackOptimal;
+		bool optimalStale;
+		long long optimalNow;
+		void nodeDown(int node);
+		void nodeUp(int node);
+
+		void build();
+		void unionSet(int left, int right);
+		void affected(GraphNode* target);
+		void rename(GraphNode* target);
+		void removeFromTree(int node);
+
+	public:
+		GraphNode* nodes;
+		SmallGraph(int numNodes, int seed);
+		SmallGraph(const SmallGraph&) = delete;
+		SmallGraph& operator=(const SmallGraph&) = delete;
+
+		//nodes are never reordered, a slot is its originalName
+		GraphNode* getNode(int node) { return &this->nodes[node]; }
+		int getCost(int i, int j) const { return this->cost[i][j]; }
+		void lowerEdges(std::vector<std::pair<int, int> >& edges) const {
+			for(int i = 0; i < numNodes; i++)
+				for(int j = 0; j < i; j++)
+					if(cost[i][j] != 0)
+						edges.push_back(std::make_pair(i, j));
+		}
+		int getNumNodes() const { return this->numNodes; }
+
+		//bit rows gain nothing from relabelling, so this keeps the order
+		void reorderNodes() { }
+
+		void rebuild();
+		void attacked(GraphNode* target);
+		void fixed(GraphNode* target);
+		bool partitioned();
+		int componentCount() const;
+		bool isCompromised(int node) const { return this->compromisedNodes.test(node); }
+		bool isAffected(int node) const { return this->affectedNodes.test(node); }
+		bool isDown(int node) const { return this->downNodes.test(node); }
+		int getCurrentName(int node) const { return this->names[node]; }
+
+		void setTrackLive(bool track);
+		int numLiveTargets() const { return this->liveNodes.size(); }
+		int liveTarget(int index) const { return this->liveNodes.at(index); }
+
+		void setTrackOptimal(bool track);
+		long long currentOptimalCost();
+
+		//Prim over the bit rows costs less than a lookup, so nothing is
+		//cached and getOptimalCache() stays empty
+		void setOptimalCache(int) { }
+		const ForestCache& getOptimalCache() const { return this->optimalCache; }
+
+		const Arena& getArena() const { return this->arena; }
+
+		long long spanningTreeCost() const;
+		long long optimalCost() const { return this->fakeCost; }
+		const std::vector<int>& missingNodes();
+};
+
+template<int MaxNodes>
+SmallGraph<MaxNodes>::SmallGraph(int numNodes, int seed) : numNodes(numNodes),
+	arena(nodeBytes(numNodes)), fakeCost(0), trackLive(false),
+	trackOptimal(false), optimalStale(true), optimalNow(0) {
+	static_assert(MaxNodes <= 256, "edge ranks are 16 bits");
+	if(numNodes > MaxNodes)
+		throw std::invalid_argument("network larger than SmallGraph");
+
+	allNodes.clear();
+	compromisedNodes.clear();
+	affectedNodes.clear();
+	downNodes.clear();
+	nodes = arena.allocateArray<GraphNode>(numNodes);
+	for(int i = 0; i < numNodes; i++) {
+		new (&nodes[i]) GraphNode(&arena);
+		nodes[i].originalName = nodes[i].index = names[i] = i;
+		nodes[i].namePathStack.push(i);
+		allNodes.set(i);
+		members[i].clear();
+		members[i].set(i);
+		adjacent[i].clear();
+		forward[i].clear();
+		tree[i].clear();
+	}
+	missing.reserve(numNodes);
+
+	std::vector<int> cells((std::size_t)numNodes * numNodes);
+	std::vector<int*> matrix(numNodes);
+	for(int i = 0; i < numNodes; i++)
+		matrix[i] = cells.data() + (std::size_t)i * numNodes;
+	randomNetwork(matrix.data(), numNodes, seed);
+
+	//the edge list in Graph's order, then sorted the way Graph sorts it
+	std::vector<int> left, right, edgeCost;
+	for(int i = 0; i < numNodes; i++)
+		for(int j = 0; j < numNodes; j++) {
+			cost[i][j] = matrix[i][j];
+			rank[i][j] = NO_EDGE;
+			if(matrix[i][j] != 0) {
+				left.push_back(i);
+				right.push_back(j);
+				edgeCost.push_back(matrix[i][j]);
+				adjacent[i].set(j);
+				adjacent[j].set(i);
+			}
+		}
+	std::vector<int> order(left.size());
+	for(unsigned int k = 0; k < order.size(); k++)
+		order[k] = k;
+	struct CostOrder {
+		const std::vector<int>& edgeCost;
+		bool operator()(int lhs, int rhs) const {  return edgeCost[lhs] < edgeCost[rhs];  }
+	} costOrder = {edgeCost};
+	std::stable_sort(order.begin(), order.end(), costOrder);
+	for(unsigned int k = 0; k < order.size(); k++) {
+		int i = left[order[k]], j = right[order[k]];
+		if(rank[i][j] == NO_EDGE) {
+			rank[i][j] = rank[j][i] = k;
+			forward[i].set(j);
+		}
+	}
+
+	build();
+}
+
+/*
+ * Minimum spanning forest of the live nodes by rank. With byName every
+ * union find set counts as one node, joined at no cost, which is the forest
+ * Graph's build() completes. Without it the forest starts from nothing, as
+ * fakeBuild() does. Leaves the edges in chosen and returns their number.
+ */
+template<int MaxNodes>
+int SmallGraph<MaxNodes>::primForest(bool byName) {
+	Set live = allNodes.without(downNodes);
+	Set reached;
+	reached.clear();
+	int numChosen = 0;
+
+	for(int root = live.first(); root != -1; root = live.without(reached).first()) {
+		Set frontier;
+		frontier.clear();
+		Set added;
+		added.clear();
+		added.set(root);
+		if(byName)
+			added = members[names[root]] & live;
+		while(true) {
+			reached |= added;
+			frontier = frontier.without(reached);
+			added.forEach([&](int u) {
+				(adjacent[u] & live).without(reached).forEach([&](int v) {
+					if(!frontier.test(v) || rank[u][v] < key[v]) {
+						key[v] = rank[u][v];
+						from[v] = u;
+						frontier.set(v);
+					}
+				});
+			});
+
+			int next = -1;
+			frontier.forEach([&](int v) {
+				if(next == -1 || key[v] < key[next])
+					next = v;
+			});
+			if(next == -1)
+				break;
+			ForestEdge edge = {key[next], from[next], next};
+			if(!forward[edge.left].test(edge.right))
+				std::swap(edge.left, edge.right);
+			chosen[numChosen++] = edge;
+
+			added.clear();
+			added.set(next);
+			if(byName)
+				added = members[names[next]] & live;
+		}
+	}
+	return numChosen;
+}
+
+template<int MaxNodes>
+long long SmallGraph<MaxNodes>::optimalForest() {
+	int numChosen = primForest(false);
+	long long total = 0;
+	for(int i = 0; i < numChosen; i++)
+		total += cost[chosen[i].left][chosen[i].right];
+	return total;
+}
+
+//the edges Kruskal would add, added in the order it would add them
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::build() {
+	int numChosen = primForest(true);
+	std::sort(chosen, chosen + numChosen);
+	for(int i = 0; i < numChosen; i++) {
+		unionSet(chosen[i].left, chosen[i].right);
+		tree[chosen[i].left].set(chosen[i].right);
+	}
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::unionSet(int left, int right) {
+	nodes[left].adjNodes.push_back(&nodes[right]);
+	nodes[right].adjNodes.push_back(&nodes[left]);
+
+	//the larger name is relabelled to the smaller one
+	int oldName = names[right];
+	int newName = names[left];
+	int via = left;
+	if(names[left] >= names[right]) {
+		oldName = names[left];
+		newName = names[right];
+		via = right;
+	}
+
+	members[oldName].forEach([&](int i) {
+		names[i] = newName;
+		nodes[i].namePathStack.push(via);
+	});
+	members[newName] |= members[oldName];
+	members[oldName].clear();
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::rebuild() {
+	{
+		STATS_TIME_REPAIR();
+		build();
+	}
+	{
+		STATS_TIME_OPTIMAL();
+		fakeCost = optimalForest();
+	}
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::fixed(GraphNode* target) {
+	STATS_TIME_OP(OP_FIXED);
+	int node = target->index;
+	compromisedNodes.reset(node);
+	affectedNodes.reset(node);
+	if(trackLive)
+		liveNodes.insert(node);
+	nodeUp(node);
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::attacked(GraphNode* target) {
+	STATS_TIME_OP(OP_ATTACKED);
+	compromisedNodes.set(target->index);
+	if(trackLive)
+		liveNodes.erase(target->index);
+	nodeDown(target->index);
+	for(unsigned int i = 0; i < target->adjNodes.size(); i++)
+		this->affected(target->adjNodes[i]);
+	this->removeFromTree(target->index);
+	this->rename(target);
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::affected(GraphNode* target) {
+	affectedNodes.set(target->index);
+	nodeDown(target->index);
+	this->removeFromTree(target->index);
+	this->rename(target);
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::nodeDown(int node) {
+	downNodes.set(node);
+	optimalStale = true;
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::nodeUp(int node) {
+	downNodes.reset(node);
+	optimalStale = true;
+}
+
+//a row and a column of bits
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::removeFromTree(int node) {
+	tree[node].clear();
+	for(int i = 0; i < numNodes; i++)
+		tree[i].reset(node);
+}
+
+//Graph::rename(), with the name change mirrored in members
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::rename(GraphNode* target) {
+	const ArenaVector<GraphNode*>& tempNodes = target->adjNodes;
+	int self = target->index;
+	if(downNodes.test(self)) {
+		members[names[self]].reset(self);
+		names[self] = self;
+		members[self].set(self);
+	}
+
+	for(unsigned int i = 0; i < tempNodes.size(); i++) {
+		GraphNode* tempNode = tempNodes[i];
+		int node = tempNode->index;
+		int currentName = names[node];
+		while((currentName != node) && downNodes.test(currentName)) {
+			int index = tempNode->namePathStack.top();
+			if(tempNode->namePathStack.size() == 1)
+				currentName = index;
+			else if(downNodes.test(index))
+				tempNode->namePathStack.pop();
+			else
+				currentName = index;
+		}
+		if(currentName != names[node]) {
+			members[names[node]].reset(node);
+			names[node] = currentName;
+			members[currentName].set(node);
+		}
+	}
+}
+
+//Graph::partitioned(): the nodes with a tree row must all share the name of
+//the first tree entry's second node
+template<int MaxNodes>
+bool SmallGraph<MaxNodes>::partitioned() {
+	STATS_TIME_OP(OP_PARTITIONED);
+	Set rows;
+	rows.clear();
+	for(int i = 0; i < numNodes; i++)
+		if(tree[i].any())
+			rows.set(i);
+	int first = rows.first();
+	if(first != -1 && rows.without(members[names[tree[first].first()]]).any()) {
+		std::cout << "The tree is partitioned." << std::endl;
+		return true;
+	}
+	std::cout << "The tree is complete." << std::endl;
+	return false;
+}
+
+template<int MaxNodes>
+int SmallGraph<MaxNodes>::componentCount() const {
+	Set live = allNodes.without(downNodes);
+	int components = 0;
+	for(int name = 0; name < numNodes; name++)
+		if((members[name] & live).any())
+			components++;
+	return components;
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::setTrackLive(bool track) {
+	if(track && !trackLive) {
+		liveNodes = NodeSampler(numNodes);
+		for(int i = 0; i < numNodes; i++)
+			if(!compromisedNodes.test(i))
+				liveNodes.insert(i);
+	}
+	trackLive = track;
+}
+
+template<int MaxNodes>
+void SmallGraph<MaxNodes>::setTrackOptimal(bool track) {
+	trackOptimal = track;
+	optimalStale = true;
+}
+
+template<int MaxNodes>
+long long SmallGraph<MaxNodes>::currentOptimalCost() {
+	if(optimalStale) {
+		optimalNow = optimalForest();
+		optimalStale = false;
+	}
+	return optimalNow;
+}
+
+template<int MaxNodes>
+long long SmallGraph<MaxNodes>::spanningTreeCost() const {
+	long long total = 0;
+	for(int i = 0; i < numNodes; i++)
+		tree[i].forEach([&](int j) {  total += cost[i][j];  });
+	return total;
+}
+
+//filled into a buffer the graph keeps, valid until the next call
+template<int MaxNodes>
+const std::vector<int>& SmallGraph<MaxNodes>::missingNodes() {
+	missing.clear();
+	downNodes.forEach([&](int node) {  missing.push_back(node);  });
+	return missing;
+}
+#endif
@@ -0,0 +1,227 @@
+//hot path instrumentation for the simulator and the graph
+//compiled in with -DSIMULATION_STATS, otherwise every STATS_ macro expands
+//to nothing and none of this code exists in the binary
+
+#ifndef STATS_H
+#define STATS_H
+
+#ifdef SIMULATION_STATS
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//Graph operations that get their own latency histogram
+enum STATS_OP {
+	OP_ATTACKED = 0,
+	OP_FIXED,
+	OP_PARTITIONED,
+	OP_REPAIR_BUILD,
+	OP_OPTIMAL_BUILD,
+	NUM_STATS_OPS
+};
+
+//one per ACTION in simulation.cpp
+const int NUM_STATS_EVENTS = 6;
+
+/*
+ * Latency histogram with log2 buckets: bucket i counts samples in
+ * [2^i, 2^(i+1)) nanoseconds. Recording is a bit scan and an increment.
+ */
+class Histogram {
+	private:
+		long long buckets[64];
+		long long count;
+		long long total;
+		long long max;
+	public:
+		Histogram() : count(0), total(0), max(0) {
+			for(int i = 0; i < 64; i++)
+				buckets[i] = 0;
+		}
+
+		void record(long long ns) {
+			int bucket = (ns > 0) ? 63 - __builtin_clzll(ns) : 0;
+			buckets[bucket]++;
+			count++;
+			total += ns;
+			if(ns > max)
+				max = ns;
+		}
+
+		long long getCount() const { return this->count; }
+		long long getTotal() const { return this->total; }
+		long long getMax() const { return this->max; }
+		double mean() const { return count ? (double)total / count : 0.0; }
+
+		//upper bound of the bucket holding the p-th percentile
+		long long percentile(double p) const {
+			long long rank = (long long)(p * count);
+			long long seen = 0;
+			for(int i = 0; i < 64; i++) {
+				seen += buckets[i];
+				if(seen > rank)
+					return (i == 63) ? max : (1LL << (i + 1));
+			}
+			return max;
+		}
+
+		void dump(std::ostream& out, const char* name) const {
+			if(count == 0)
+				return;
+			out << "  " << name << ": count " << count << ", mean " << (long long)mean()
+				<< " ns, p50 < " << percentile(0.5) << " ns, p99 < " << percentile(0.99)
+				<< " ns, max " << max << " ns" << std::endl;
+		}
+};
+
+//state of the simulation at one rebuild
+struct StatsSample {
+	int time;
+	int heapOccupancy;
+	int fixQueueLength;
+	int components;
+	long long repairNs;
+	long long optimalNs;
+};
+
+class Stats {
+	private:
+		long long numEvents;
+		long long dumpInterval;
+		int maxHeapOccupancy;
+		int maxFixQueueLength;
+	public:
+		Histogram events[NUM_STATS_EVENTS];
+		Histogram ops[NUM_STATS_OPS];
+		std::vector<StatsSample> samples;
+
+		//most recent rebuild durations, filled in by StatsTimer
+		long long lastRepairNs;
+		long long lastOptimalNs;
+
+		//optimal forest cache lookups at rebuilds
+		long long optimalLookups;
+		long long optimalHits;
+
+		//SIMULATION_STATS_DUMP=<events> turns on the periodic dump
+		Stats() : numEvents(0), dumpInterval(0), maxHeapOccupancy(0), maxFixQueueLength(0),
+			lastRepairNs(0), lastOptimalNs(0), optimalLookups(0), optimalHits(0) {
+			const char* interval = std::getenv("SIMULATION_STATS_DUMP");
+			if(interval)
+				dumpInterval = std::atoll(interval);
+		}
+
+		void setDumpInterval(long long events) { this->dumpInterval = events; }
+		long long getNumEvents() const { return this->numEvents; }
+		int getMaxHeapOccupancy() const { return this->maxHeapOccupancy; }
+		int getMaxFixQueueLength() const { return this->maxFixQueueLength; }
+
+		//called once per processed event with the current queue depths
+		void event(int heapOccupancy, int fixQueueLength) {
+			numEvents++;
+			if(heapOccupancy > maxHeapOccupancy)
+				maxHeapOccupancy = heapOccupancy;
+			if(fixQueueLength > maxFixQueueLength)
+				maxFixQueueLength = fixQueueLength;
+			if(dumpInterval > 0 && numEvents % dumpInterval == 0)
+				dump(std::cerr);
+		}
+
+		void optimalCache(bool hit) {
+			optimalLookups++;
+			if(hit)
+				optimalHits++;
+		}
+
+		double optimalHitRate() const {  return optimalLookups ? (double)optimalHits / optimalLookups : 0.0;  }
+
+		void sample(int time, int heapOccupancy, int fixQueueLength, int components) {
+			StatsSample s;
+			s.time = time;
+			s.heapOccupancy = heapOccupancy;
+			s.fixQueueLength = fixQueueLength;
+			s.components = components;
+			s.repairNs = lastRepairNs;
+			s.optimalNs = lastOptimalNs;
+			samples.push_back(s);
+		}
+
+		void dump(std::ostream& out) const {
+			static const char* eventNames[NUM_STATS_EVENTS] = {
+				"DEPLOY_REBUILD", "EXECUTE_REBUILD", "DEPLOY_FIX",
+				"EXECUTE_FIX", "DEPLOY_ATTACK", "EXECUTE_ATTACK"
+			};
+			static const char* opNames[NUM_STATS_OPS] = {
+				"attacked", "fixed", "partitioned", "repair_build", "optimal_build"
+			};
+			out << "STATS after " << numEvents << " events (max heap " << maxHeapOccupancy
+				<< ", max fix queue " << maxFixQueueLength << ")" << std::endl;
+			for(int i = 0; i < NUM_STATS_EVENTS; i++)
+				events[i].dump(out, eventNames[i]);
+			for(int i = 0; i < NUM_STATS_OPS; i++)
+				ops[i].dump(out, opNames[i]);
+			if(optimalLookups > 0)
+				out << "  optimal cache: " << optimalHits << " hits of " << optimalLookups
+					<< " lookups (" << (int)(100 * optimalHitRate() + 0.5) << "%)" << std::endl;
+			if(!samples.empty()) {
+				const StatsSample& last = samples.back();
+				out << "  rebuilds: " << samples.size() << ", last at " << last.time
+					<< " with " << last.components << " components" << std::endl;
+			}
+		}
+};
+
+//one set of stats per process
+inline Stats& simulationStats() {
+	static Stats stats;
+	return stats;
+}
+
+//records the lifetime of the enclosing scope into a histogram
+class StatsTimer {
+	private:
+		Histogram& histogram;
+		long long* last;
+		std::chrono::steady_clock::time_point start;
+	public:
+		StatsTimer(Histogram& histogram, long long* last = nullptr)
+			: histogram(histogram), last(last), start(std::chrono::steady_clock::now()) { }
+		~StatsTimer() {
+			long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count();
+			histogram.record(ns);
+			if(last)
+				*last = ns;
+		}
+};
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+#define STATS_TIME_EVENT(action) \
+	StatsTimer STATS_CONCAT(statsTimer, __LINE__)(simulationStats().events[action])
+#define STATS_TIME_OP(op) \
+	StatsTimer STATS_CONCAT(statsTimer, __LINE__)(simulationStats().ops[op])
+#define STATS_TIME_REPAIR() \
+	StatsTimer STATS_CONCAT(statsTimer, __LINE__)(simulationStats().ops[OP_REPAIR_BUILD], \
+		&simulationStats().lastRepairNs)
+#define STATS_TIME_OPTIMAL() \
+	StatsTimer STATS_CONCAT(statsTimer, __LINE__)(simulationStats().ops[OP_OPTIMAL_BUILD], \
+		&simulationStats().lastOptimalNs)
+#define STATS_EVENT(heap, fixQueue) simulationStats().event(heap, fixQueue)
+#define STATS_OPTIMAL_CACHE(hit) simulationStats().optimalCache(hit)
+#define STATS_SAMPLE(time, heap, fixQueue, components) \
+	simulationStats().sample(time, heap, fixQueue, components)
+
+#else
+
+#define STATS_TIME_EVENT(action)
+#define STATS_TIME_OP(op)
+#define STATS_TIME_REPAIR()
+#define STATS_TIME_OPTIMAL()
+#define STATS_EVENT(heap, fixQueue)
+#define STATS_OPTIMAL_CACHE(hit)
+#define STATS_SAMPLE(time, heap, fixQueue, components)
+
+#endif
+#endif
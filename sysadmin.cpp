@@ -4,34 +4,51 @@
 #ifndef SYSADMIN_H
 #define SYSADMIN_H
 #include "graph.hpp" 
-#include <queue> //queue STL
+#include <vector>
 
+//a node is only queued while it is not already in the queue, so a ring of
+//numComputers slots always has room and pushing never allocates. push()
+//ignores a node that is already queued, so no caller can overrun the ring
 class SysAdmin {
 	private:
-		std::queue<GraphNode*> queue;
-		bool* networkTable;
+		std::vector<GraphNode*> queue;
+		int head;
+		int length;
+		std::vector<char> networkTable;
 		int numComputers;
 	public:
-		SysAdmin(int numComputers) { //constructor 
+		SysAdmin(int numComputers) : queue(numComputers > 0 ? numComputers : 1), head(0), length(0),
+			networkTable(numComputers, 0) { //constructor 
 			this->numComputers = numComputers;
-			networkTable = new bool[numComputers];
-			for(int i = 0; i < numComputers; i++) 
-				 networkTable[i] = false;
 		}
 		void push(GraphNode* node) {
-			queue.push(node);
+			if(networkTable[node->originalName])
+				return;
+			int tail = head + length;
+			if(tail >= (int)queue.size())
+				tail -= queue.size();
+			queue[tail] = node;
+			length++;
 			networkTable[node->originalName] = 1;
 		}
 		GraphNode* pop() {
-			GraphNode* temp = queue.front();
-			queue.pop();
+			GraphNode* temp = queue[head];
+			if(++head == (int)queue.size())
+				head = 0;
+			length--;
 			networkTable[temp->originalName] = 0;
 			return temp;
 		}
 		bool check(GraphNode* node) {
 			return networkTable[node->originalName];
 		}
+		bool isEmpty() {
+			return length == 0;
+		}
+		int size() {
+			return length;
+		}
 };
 
-	
+
 #endif 
@@ -0,0 +1,90 @@
+//a warmed up simulation calls operator new no more: every engine and
+//network, with each simulator option, --metrics and --shards, runs 1000
+//events and then the rest of the run under a counting operator new that
+//must not move. New arena blocks are allowed, since adjNodes and name path
+//stacks grow with the run
+
+#include "../simulator.hpp"
+#include "../agents.hpp"
+#include "../countnew.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <unistd.h>
+
+//swallows everything the simulator prints
+class NullBuffer : public std::streambuf {
+	protected:
+		int overflow(int c) { return c; }
+		std::streamsize xsputn(const char*, std::streamsize n) { return n; }
+};
+
+static int failures = 0;
+
+template<typename SimulatorType>
+static void check(const char* engine, const char* options, int attackers, int n, int seed) {
+	std::string path = "/tmp/alloc_test_" + std::to_string(getpid()) + ".desm";
+	MetricsWriter* metrics = nullptr;
+	if(strstr(options, "metrics"))
+		metrics = new MetricsWriter(path.c_str(), n);
+	long long allocations, events;
+	{
+		SimulatorType simulator(attackers, 20, n, seed);
+		if(strstr(options, "reorder"))
+			simulator.getNetwork().reorderNodes();
+		simulator.setBatchAttacks(strstr(options, "batch") != nullptr);
+		simulator.setSampleLive(strstr(options, "live") != nullptr);
+		simulator.setTrackOptimal(strstr(options, "optimal") != nullptr);
+		if(metrics)
+			simulator.setMetrics(metrics);
+
+		while(simulator.getNumEvents() < 1000 && !simulator.finished() && simulator.step()) { }
+		allocations = numAllocations;
+		events = simulator.getNumEvents();
+		while(!simulator.finished() && simulator.step()) { }
+		allocations = numAllocations - allocations;
+		events = simulator.getNumEvents() - events;
+	}
+	delete metrics;
+	std::remove(path.c_str());
+
+	if(allocations != 0 || events == 0) {
+		std::fprintf(stdout, "FAIL %s [%s] n=%d attackers=%d seed=%d: %lld allocations in %lld events\n",
+			engine, options, n, attackers, seed, allocations, events);
+		failures++;
+	}
+}
+
+int main() {
+	NullBuffer nullBuffer;
+	std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+	static const char* configs[] = {"", "batch", "live", "optimal", "reorder", "metrics", "batch,live,optimal,metrics"};
+	int sizes[] = {30, 100};
+	int attackers[] = {5, 20};
+	for(unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		for(unsigned int j = 0; j < sizeof(attackers) / sizeof(attackers[0]); j++)
+			for(unsigned int k = 0; k < sizeof(configs) / sizeof(configs[0]); k++) {
+				int seed = 1 + 7 * k;
+				check<Simulator>("events", configs[k], attackers[j], sizes[i], seed);
+				check<BasicSimulator<PriorityQueue<Event, tiebreaker>, Graph, SysAdmin, XoshiroRNG<> > >(
+					"events_xoshiro", configs[k], attackers[j], sizes[i], seed);
+				check<BasicSimulator<PriorityQueue<Event, tiebreaker>, SmallGraph<256> > >(
+					"events_small", configs[k], attackers[j], sizes[i], seed);
+				check<AgentSimulator<> >("coroutines", configs[k], attackers[j], sizes[i], seed);
+			}
+
+	//the workers are separate processes, only the simulating one is counted
+	static const char* shardConfigs[] = {"", "metrics", "batch,live,optimal,metrics"};
+	ShardedGraph::setDefaultWorkers(2);
+	for(unsigned int k = 0; k < sizeof(shardConfigs) / sizeof(shardConfigs[0]); k++) {
+		check<BasicSimulator<PriorityQueue<Event, tiebreaker>, ShardedGraph> >("events_shards", shardConfigs[k], 5, 30, 1);
+		check<BasicSimulator<PriorityQueue<Event, tiebreaker>, ShardedGraph> >("events_shards", shardConfigs[k], 20, 100, 7);
+	}
+
+	std::cout.rdbuf(coutBuffer);
+	std::cout << (failures ? "alloc_test failed" : "alloc_test passed") << std::endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+//every export lists each connected pair of the adjacency matrix once, with
+//the cost Graph::setTrackOptimal() takes for it: left < right when that
+//direction exists, the one way edge otherwise
+
+#include "../export.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+	if(!ok) {
+		std::cout << "FAIL " << what << std::endl;
+		failures++;
+	}
+}
+
+//edge count and total cost straight from the matrix
+static void matrixTotals(const Graph& g, long long& count, long long& cost) {
+	const int* const* adjMatrix = g.getAdjMatrix();
+	count = cost = 0;
+	for(int i = 0; i < g.getNumNodes(); i++)
+		for(int j = i + 1; j < g.getNumNodes(); j++) {
+			int forward = adjMatrix[g.slot(i)][g.slot(j)];
+			int backward = adjMatrix[g.slot(j)][g.slot(i)];
+			if(forward != 0 || backward != 0) {
+				count++;
+				cost += forward != 0 ? forward : backward;
+			}
+		}
+}
+
+//the whole export of one format
+static std::string exported(const Graph& g, EXPORT_FORMAT format) {
+	std::FILE* file = std::tmpfile();
+	{
+		ExportBuffer buffer(file);
+		exportGraph(g, format, buffer);
+	}
+	std::string text;
+	std::rewind(file);
+	char chunk[4096];
+	std::size_t length;
+	while((length = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+		text.append(chunk, length);
+	std::fclose(file);
+	return text;
+}
+
+static void csvTotals(const std::string& text, long long& count, long long& cost) {
+	count = cost = 0;
+	std::size_t line = text.find('\n') + 1;   //header
+	while(line < text.size()) {
+		int left, right, edgeCost, tree;
+		if(std::sscanf(text.c_str() + line, "%d,%d,%d,%d", &left, &right, &edgeCost, &tree) == 4) {
+			count++;
+			cost += edgeCost;
+		}
+		line = text.find('\n', line) + 1;
+	}
+}
+
+static void dotTotals(const std::string& text, long long& count, long long& cost) {
+	count = cost = 0;
+	for(std::size_t at = text.find("[label="); at != std::string::npos; at = text.find("[label=", at + 1)) {
+		count++;
+		cost += atoi(text.c_str() + at + 7);
+	}
+}
+
+static void binaryTotals(const std::string& text, long long& count, long long& cost) {
+	count = cost = 0;
+	if(text.size() < 20 || text.compare(0, 4, "DESG") != 0)
+		return;
+	int32_t header[4];
+	std::memcpy(header, text.data() + 4, sizeof(header));
+	count = header[2];
+	for(int i = 0; i < header[2]; i++) {
+		int32_t record[3];
+		std::memcpy(record, text.data() + 20 + i * sizeof(record), sizeof(record));
+		cost += record[2];
+	}
+}
+
+static void check(int numNodes, int seed) {
+	Graph g(numNodes, seed);
+	long long count, cost;
+	matrixTotals(g, count, cost);
+
+	std::string name = "n=" + std::to_string(numNodes) + " seed=" + std::to_string(seed);
+	long long csvCount, csvCost, dotCount, dotCost, binaryCount, binaryCost;
+	csvTotals(exported(g, FORMAT_CSV), csvCount, csvCost);
+	dotTotals(exported(g, FORMAT_DOT), dotCount, dotCost);
+	binaryTotals(exported(g, FORMAT_BINARY), binaryCount, binaryCost);
+	expect(csvCount == count && csvCost == cost, "csv " + name);
+	expect(dotCount == count && dotCost == cost, "dot " + name);
+	expect(binaryCount == count && binaryCost == cost, "binary " + name);
+}
+
+int main() {
+	//5 nodes with seed 100 has a one way edge 1 -> 0 in its tree
+	int sizes[] = {1, 2, 5, 17, 50, 200};
+	for(unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		for(int seed = 1; seed <= 100; seed += 33)
+			check(sizes[i], seed);
+	check(5, 100);
+
+	std::cout << (failures ? "export_test failed" : "export_test passed") << std::endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+//rows written by MetricsWriter read back unchanged through MetricsReader,
+//across block boundaries and blocks written early by the change budget, and
+//a damaged file reads as ending early instead of sizing anything from it
+
+#include "../metrics.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static int failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+	if(!ok) {
+		std::cout << "FAIL " << what << std::endl;
+		failures++;
+	}
+}
+
+static std::string temporaryPath() {
+	char path[] = "/tmp/metrics_test_XXXXXX";
+	int fd = mkstemp(path);
+	if(fd != -1)
+		close(fd);
+	return path;
+}
+
+//rows of random sorted missing sets, with runs of five rows flipping every
+//node whose change bytes push a block over its budget
+static std::vector<MetricsRow> makeRows(int numNodes, int numRows, int seed) {
+	std::srand(seed);
+	std::vector<MetricsRow> rows(numRows);
+	std::vector<bool> down(numNodes, false);
+	for(int r = 0; r < numRows; r++) {
+		int flips = r % 10 >= 5 ? numNodes : std::rand() % 4;
+		for(int k = 0; k < flips; k++) {
+			int node = r % 10 >= 5 ? k : std::rand() % numNodes;
+			down[node] = !down[node];
+		}
+		rows[r].time = r * 3;
+		rows[r].treeCost = 1000000000000LL + std::rand();
+		rows[r].optimalCost = std::rand();
+		rows[r].components = 1 + std::rand() % 5;
+		for(int node = 0; node < numNodes; node++)
+			if(down[node])
+				rows[r].missing.push_back(node);
+	}
+	return rows;
+}
+
+static void roundTrip(int numNodes, int numRows, int blockRows) {
+	std::string name = "n=" + std::to_string(numNodes) + " rows=" + std::to_string(numRows)
+		+ " blockRows=" + std::to_string(blockRows);
+	std::string path = temporaryPath();
+	std::vector<MetricsRow> rows = makeRows(numNodes, numRows, numNodes + blockRows);
+	{
+		MetricsWriter writer(path.c_str(), numNodes, blockRows);
+		for(unsigned int r = 0; r < rows.size(); r++)
+			writer.append(rows[r].time, rows[r].treeCost, rows[r].optimalCost, rows[r].components, rows[r].missing);
+	}
+
+	MetricsReader reader(path.c_str());
+	expect(reader.isOpen() && reader.getNumNodes() == numNodes, "header " + name);
+	MetricsRow row;
+	int read = 0;
+	while(reader.next(row)) {
+		if(read < numRows) {
+			const MetricsRow& want = rows[read];
+			bool same = row.time == want.time && row.treeCost == want.treeCost
+				&& row.optimalCost == want.optimalCost && row.components == want.components
+				&& row.missing == want.missing;
+			expect(same, name + " row " + std::to_string(read));
+		}
+		read++;
+	}
+	expect(read == numRows, "row count " + name);
+
+	//a block short of blockRows before the last one was written early
+	MetricsReader blocks(path.c_str());
+	int numBlocks = 0;
+	bool early = false;
+	while(blocks.readBlock()) {
+		expect(blocks.getBlock().rows() <= blockRows, "block size " + name);
+		early |= numBlocks > 0 && blocks.getBlock().rows() < blockRows;
+		numBlocks++;
+	}
+	expect(numBlocks > 1, "block boundary " + name);
+	expect(early, "early block " + name);
+	std::remove(path.c_str());
+}
+
+//a valid file header followed by the given block bytes
+static std::string damaged(const std::vector<int32_t>& header, const std::vector<unsigned char>& body) {
+	std::string path = temporaryPath();
+	std::FILE* out = std::fopen(path.c_str(), "wb");
+	int32_t fileHeader[2] = {1, 8};
+	std::fwrite("DESM", 1, 4, out);
+	std::fwrite(fileHeader, sizeof(int32_t), 2, out);
+	std::fwrite(header.data(), sizeof(int32_t), header.size(), out);
+	std::fwrite(body.data(), 1, body.size(), out);
+	std::fclose(out);
+	return path;
+}
+
+static void checkDamaged() {
+	MetricsRow row;
+	std::vector<unsigned char> none;
+
+	//more rows than a writer ever puts in a block
+	std::string path = damaged({1 << 30, 0}, none);
+	{
+		MetricsReader reader(path.c_str());
+		expect(!reader.readBlock() && reader.getBlock().rows() == 0, "oversized rows");
+	}
+	std::remove(path.c_str());
+
+	//more change bytes than the file has left
+	path = damaged({1, 1 << 30, 0, 0, 0, 0, 0, 0, 0, 0}, none);
+	{
+		MetricsReader reader(path.c_str());
+		expect(!reader.next(row), "oversized change bytes");
+	}
+	std::remove(path.c_str());
+
+	//one row claiming more changes than nodes, a varint that never ends and
+	//gaps past the last node
+	std::vector<unsigned char> changes = {0, 0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 1, 1, 1, 1, 1, 1, 1};
+	path = damaged({1, (int32_t)changes.size(), 5, 0, 0, 0, 0, 0, 0, 1, 0, 1000}, changes);
+	{
+		MetricsReader reader(path.c_str());
+		bool ok = reader.next(row);
+		expect(ok && row.time == 5 && row.missing.size() <= 8, "runaway changes");
+		for(unsigned int i = 0; i < row.missing.size(); i++)
+			expect(row.missing[i] >= 0 && row.missing[i] < 8 && (i == 0 || row.missing[i - 1] < row.missing[i]), "runaway node");
+		expect(!reader.next(row), "runaway end");
+	}
+	std::remove(path.c_str());
+}
+
+int main() {
+	roundTrip(40, 60, 64);
+	roundTrip(30, 100, 7);
+	roundTrip(200, 300, 16);
+	roundTrip(1000, 50, 8);
+	checkDamaged();
+
+	std::cout << (failures ? "metrics_test failed" : "metrics_test passed") << std::endl;
+	return failures ? 1 : 0;
+}